@@ -0,0 +1,331 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+// Interaction benchmarks of the main window on a synthetic library.
+//
+// usage: songbook-gui-bench [--songs N] [QTest options]
+//
+// The real CMainWindow is driven with QTest in a temporary home
+// directory. Qt 4 has no offscreen platform, on machines without a
+// display the suite runs in a virtual X server (xvfb-run -a).
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QScrollBar>
+#include <QTableView>
+#include <QTabWidget>
+#include <QTextCodec>
+#include <QtTest>
+
+#include <algorithm>
+
+#include "mainwindow.hh"
+#include "library.hh"
+#include "filter-lineedit.hh"
+#include "synthetic-library.hh"
+
+namespace
+{
+  // songs of the songbook opened by openSongbook()
+  const int SongbookSize = 1500;
+  const int EditorCount = 40;
+  const int ScrollFrames = 200;
+
+  double milliseconds(const QElapsedTimer & timer)
+  {
+    return timer.nsecsElapsed() / 1000000.0;
+  }
+
+  QString summary(QList<double> times)
+  {
+    if (times.isEmpty())
+      return QString();
+
+    qSort(times);
+    double total = 0;
+    foreach (double time, times)
+      total += time;
+    return QString("mean %1 ms, median %2 ms, p95 %3 ms, max %4 ms")
+      .arg(total / times.size(), 0, 'f', 2)
+      .arg(times[times.size() / 2], 0, 'f', 2)
+      .arg(times[qMin(times.size() - 1, times.size() * 95 / 100)], 0, 'f', 2)
+      .arg(times.last(), 0, 'f', 2);
+  }
+
+  double mean(const QList<double> & times)
+  {
+    double total = 0;
+    foreach (double time, times)
+      total += time;
+    return times.isEmpty() ? 0 : total / times.size();
+  }
+}
+
+/** \class CGuiBench
+ * \brief CGuiBench measures the latency of the interactions with the library
+ */
+class CGuiBench : public QObject
+{
+  Q_OBJECT
+
+public:
+  CGuiBench(CSyntheticLibrary *library)
+    : m_library(library)
+    , m_window(0)
+  {}
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+
+  void scrollFrameTime();
+  void filterKeystroke_data();
+  void filterKeystroke();
+  void selectAll();
+  void invertSelection();
+  void openSongbook();
+  void tabSwitch();
+  void dataPerRole_data();
+  void dataPerRole();
+
+private:
+  /// Paints the library view as after an interaction.
+  void paint();
+  void invoke(const char *slot);
+
+  CSyntheticLibrary *m_library;
+  CMainWindow *m_window;
+};
+
+//------------------------------------------------------------------------------
+void CGuiBench::initTestCase()
+{
+  m_window = new CMainWindow;
+  m_window->resize(1024, 768);
+  m_window->show();
+  QTest::qWaitForWindowShown(m_window);
+  QVERIFY(m_window->library()->songIds().count() == m_library->songs().size());
+}
+//------------------------------------------------------------------------------
+void CGuiBench::cleanupTestCase()
+{
+  delete m_window;
+  m_window = 0;
+}
+//------------------------------------------------------------------------------
+void CGuiBench::paint()
+{
+  QApplication::processEvents();
+  m_window->view()->viewport()->repaint();
+}
+//------------------------------------------------------------------------------
+void CGuiBench::invoke(const char *slot)
+{
+  // the actions of the window are private slots
+  QVERIFY(QMetaObject::invokeMethod(m_window, slot));
+}
+//------------------------------------------------------------------------------
+void CGuiBench::scrollFrameTime()
+{
+  QScrollBar *scrollBar = m_window->view()->verticalScrollBar();
+  scrollBar->setValue(0);
+  paint();
+
+  QList<double> frames;
+  QElapsedTimer timer;
+  for (int frame = 0; frame < ScrollFrames; ++frame)
+    {
+      timer.start();
+      scrollBar->setValue(scrollBar->value() + scrollBar->singleStep() * 3);
+      paint();
+      frames << milliseconds(timer);
+    }
+  qDebug() << "scroll frame:" << qPrintable(summary(frames));
+  QTest::setBenchmarkResult(mean(frames), QTest::WalltimeMilliseconds);
+}
+//------------------------------------------------------------------------------
+void CGuiBench::filterKeystroke_data()
+{
+  QTest::addColumn<QString>("filter");
+  QTest::newRow("text") << "bala";
+  QTest::newRow("field") << "artist:ma";
+  QTest::newRow("negation") << "la -lang:french";
+}
+//------------------------------------------------------------------------------
+void CGuiBench::filterKeystroke()
+{
+  QFETCH(QString, filter);
+  CFilterLineEdit *lineEdit = m_window->findChild<CFilterLineEdit*>();
+  QVERIFY(lineEdit);
+  lineEdit->clear();
+  paint();
+
+  QList<double> latencies;
+  QElapsedTimer timer;
+  foreach (const QChar & character, filter)
+    {
+      timer.start();
+      QTest::keyClicks(lineEdit, QString(character));
+      paint();
+      latencies << milliseconds(timer);
+    }
+  lineEdit->clear();
+  paint();
+
+  qDebug() << "keystroke to repaint:" << qPrintable(summary(latencies));
+  QTest::setBenchmarkResult(mean(latencies), QTest::WalltimeMilliseconds);
+}
+//------------------------------------------------------------------------------
+void CGuiBench::selectAll()
+{
+  QBENCHMARK
+    {
+      invoke("selectAll");
+      paint();
+      invoke("unselectAll");
+      paint();
+    }
+}
+//------------------------------------------------------------------------------
+void CGuiBench::invertSelection()
+{
+  QBENCHMARK
+    {
+      invoke("invertSelection");
+      paint();
+    }
+}
+//------------------------------------------------------------------------------
+void CGuiBench::openSongbook()
+{
+  QString filename = m_library->writeSongbook("benchmark.sb", SongbookSize);
+  QVERIFY(!filename.isEmpty());
+
+  QBENCHMARK_ONCE
+    {
+      QVERIFY(QMetaObject::invokeMethod(m_window, "open", Q_ARG(QString, filename)));
+      paint();
+    }
+  invoke("unselectAll");
+}
+//------------------------------------------------------------------------------
+void CGuiBench::tabSwitch()
+{
+  QTabWidget *tabs = qobject_cast<QTabWidget*>(m_window->centralWidget());
+  QVERIFY(tabs);
+
+  QStringList songs = m_library->songs();
+  for (int i = 0; i < EditorCount && i < songs.size(); ++i)
+    QVERIFY(QMetaObject::invokeMethod(m_window, "songEditor",
+				      Q_ARG(QString, songs[i]),
+				      Q_ARG(QString, QString())));
+  QApplication::processEvents();
+
+  QList<double> switches;
+  QElapsedTimer timer;
+  QBENCHMARK
+    {
+      for (int i = 0; i < tabs->count(); ++i)
+	{
+	  timer.start();
+	  tabs->setCurrentIndex(i);
+	  QApplication::processEvents();
+	  tabs->currentWidget()->repaint();
+	  switches << milliseconds(timer);
+	}
+    }
+  qDebug() << "tab switch among" << tabs->count() << "tabs:" << qPrintable(summary(switches));
+
+  tabs->setCurrentIndex(0);
+  for (int i = tabs->count() - 1; i > 0; --i)
+    QMetaObject::invokeMethod(m_window, "closeTab", Q_ARG(int, i));
+}
+//------------------------------------------------------------------------------
+void CGuiBench::dataPerRole_data()
+{
+  QTest::addColumn<int>("role");
+  QTest::newRow("display") << int(Qt::DisplayRole);
+  QTest::newRow("decoration") << int(Qt::DecorationRole);
+  QTest::newRow("size hint") << int(Qt::SizeHintRole);
+  QTest::newRow("tool tip") << int(Qt::ToolTipRole);
+  QTest::newRow("font") << int(Qt::FontRole);
+}
+//------------------------------------------------------------------------------
+void CGuiBench::dataPerRole()
+{
+  QFETCH(int, role);
+  CLibrary *library = m_window->library();
+  int rows = qMin(library->rowCount(), 1000);
+  int columns = library->columnCount();
+
+  // the rows painted by a few screens of the view
+  QBENCHMARK
+    {
+      for (int row = 0; row < rows; ++row)
+	for (int column = 0; column < columns; ++column)
+	  library->data(library->index(row, column), role);
+    }
+}
+
+//******************************************************************************
+int main(int argc, char *argv[])
+{
+  // --songs is handled here, the other arguments are given to QTest
+  int songs = 20000;
+  QStringList arguments;
+  for (int i = 0; i < argc; ++i)
+    {
+      if (!qstrcmp(argv[i], "--songs") && i + 1 < argc)
+	songs = QString(argv[++i]).toInt();
+      else
+	arguments << QString::fromLocal8Bit(argv[i]);
+    }
+
+  // must be set before the settings and the database are located
+  QString home = QString("%1/songbook-gui-bench-%2")
+    .arg(QDir::tempPath()).arg(QCoreApplication::applicationPid());
+  QDir().mkpath(home);
+  qputenv("HOME", QFile::encodeName(home));
+  qputenv("XDG_CONFIG_HOME", QFile::encodeName(home + "/.config"));
+  qputenv("XDG_CACHE_HOME", QFile::encodeName(home + "/.cache"));
+
+  QApplication app(argc, argv);
+  Q_INIT_RESOURCE(songbook);
+  QCoreApplication::setOrganizationName("Patacrep");
+  QCoreApplication::setOrganizationDomain("patacrep.com");
+  QCoreApplication::setApplicationName("songbook-client");
+  QTextCodec::setCodecForCStrings(QTextCodec::codecForName("UTF-8"));
+
+  CSyntheticLibrary library(QString("%1/songbook").arg(home));
+  int status = 1;
+  if (library.generate(songs))
+    {
+      CGuiBench bench(&library);
+      status = QTest::qExec(&bench, arguments);
+    }
+  else
+    {
+      qWarning() << "unable to generate the library in" << library.workingPath();
+    }
+
+  CSyntheticLibrary::removeDirectory(home);
+  return status;
+}
+
+#include "gui-bench.moc"
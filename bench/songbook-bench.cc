@@ -0,0 +1,722 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+// Headless benchmark of the library on synthetic songs.
+//
+// usage: songbook-bench [--sizes 1000,10000,100000] [--repeat N]
+//                       [--songs-per-artist N] [--songs-per-album N]
+//                       [--covers RATIO] [--lilypond RATIO]
+//                       [--languages english:0.4,french:0.4,...]
+//                       [--output FILE] [--baseline FILE] [--tolerance RATIO]
+//
+// For each size, a library is generated in a temporary directory and
+// the stages of the ingest and of the browsing are timed: directory
+// walk, header parsing, database insert, filter, sort, selection and
+// lyrics scan. The results are written as JSON. Given a baseline in
+// the same format, the benchmark fails when a stage is slower than the
+// baseline by more than the tolerance. It is skipped, returning 77,
+// when the baseline does not exist yet.
+//
+// With the GNU C library, the allocations per song of reading and
+// storing the songs are also counted, for the ingest and for the
+// previous implementation kept below as reference.
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QRegExp>
+#include <QScriptEngine>
+#include <QScriptValue>
+#include <QSqlDatabase>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlTableModel>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "ingest-arena.hh"
+#include "library.hh"
+#include "lyrics-search.hh"
+#include "song-query.hh"
+#include "song-writer.hh"
+#include "synthetic-library.hh"
+#include "utils/bitset.hh"
+#include "utils/string-pool.hh"
+#include "utils/utils.hh"
+
+#if defined(__GLIBC__)
+// counts the allocations of the process, those of Qt and SQLite
+// included, by wrapping the allocator of the C library
+#define SB_COUNT_ALLOCATIONS
+namespace
+{
+  volatile long allocationCount = 0;
+}
+
+extern "C"
+{
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t count, size_t size);
+  void *__libc_realloc(void *pointer, size_t size);
+
+  void *malloc(size_t size) __THROW
+  {
+    __sync_fetch_and_add(&allocationCount, 1);
+    return __libc_malloc(size);
+  }
+
+  void *calloc(size_t count, size_t size) __THROW
+  {
+    __sync_fetch_and_add(&allocationCount, 1);
+    return __libc_calloc(count, size);
+  }
+
+  void *realloc(void *pointer, size_t size) __THROW
+  {
+    __sync_fetch_and_add(&allocationCount, 1);
+    return __libc_realloc(pointer, size);
+  }
+}
+#endif
+
+namespace
+{
+  const char *ConnectionName = "songbook-bench";
+
+  // filters typed in the filter bar, see CSongQuery
+  const char *queries[] = {
+    "ba",
+    "artist:ma",
+    "lang:french",
+    "lilypond:yes",
+    "title:le -album:ra",
+    "artist:ba OR album:\"Lo\""
+  };
+  const int queryCount = sizeof(queries) / sizeof(queries[0]);
+
+  // differences below are noise, in ms
+  const double MinimalDifference = 1.0;
+
+  struct Allocations
+  {
+    QString name;
+    int songs;
+    double reference;
+    double current;
+  };
+
+  struct Result
+  {
+    QString name;
+    int songs;
+    QList<double> times;
+
+    double median() const
+    {
+      QList<double> sorted = times;
+      qSort(sorted);
+      return sorted[sorted.size() / 2];
+    }
+
+    double minimum() const
+    {
+      return *std::min_element(times.begin(), times.end());
+    }
+  };
+
+  class LyricsScan
+  {
+  public:
+    typedef QList<CLyricsHit> result_type;
+
+    LyricsScan(const QByteArray & pattern) : m_pattern(pattern) {}
+
+    QList<CLyricsHit> operator()(const QString & path) const
+    {
+      return CLyricsSearch::searchFile(path, m_pattern, false);
+    }
+
+  private:
+    QByteArray m_pattern;
+  };
+
+  double milliseconds(const QElapsedTimer & timer)
+  {
+    return timer.nsecsElapsed() / 1000000.0;
+  }
+
+  QString argument(const QStringList & arguments, const QString & name,
+		   const QString & value = QString())
+  {
+    int index = arguments.indexOf(name);
+    if (index < 0 || index + 1 >= arguments.size())
+      return value;
+    return arguments[index + 1];
+  }
+
+  QString jsonString(const QString & text)
+  {
+    QString str(text);
+    str.replace("\\", "\\\\");
+    str.replace("\"", "\\\"");
+    return QString("\"%1\"").arg(str);
+  }
+
+  QString key(const QString & name, int songs)
+  {
+    return QString("%1@%2").arg(name).arg(songs);
+  }
+
+  //----------------------------------------------------------------------------
+  // stages, each returns the duration of one run in ms
+
+  double walk(const QString & workingPath, QStringList & paths)
+  {
+    QElapsedTimer timer;
+    timer.start();
+    paths.clear();
+    QDirIterator it(QString("%1/songs/").arg(workingPath), QStringList() << "*.sg",
+		    QDir::NoFilter, QDirIterator::Subdirectories);
+    while (it.hasNext())
+      paths << it.next();
+    return milliseconds(timer);
+  }
+
+  double parse(const QStringList & paths, QVector<CSong> & songs)
+  {
+    QElapsedTimer timer;
+    timer.start();
+    songs.clear();
+    songs.reserve(paths.size());
+    CStringPool strings;
+    CIngestArena arena(&strings);
+    foreach (const QString & path, paths)
+      {
+	CSong song;
+	if (!arena.read(path, song))
+	  continue;
+	song.artistKey = SbUtils::collationKey(song.artist);
+	song.titleKey = SbUtils::collationKey(song.title);
+	songs.append(song);
+      }
+    return milliseconds(timer);
+  }
+
+  double insert(const QString & databasePath, const QVector<CSong> & songs)
+  {
+    QFile::remove(databasePath);
+    double duration = 0;
+    {
+      QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", ConnectionName);
+      db.setDatabaseName(databasePath);
+      if (!db.open())
+	return -1;
+      CLibrary::createTables(db);
+
+      // as CLibrary::retrieveSongs()
+      QElapsedTimer timer;
+      timer.start();
+      db.transaction();
+      {
+	CSongWriter writer(db);
+	foreach (const CSong & song, songs)
+	  writer.insert(song);
+      }
+      db.commit();
+      duration = milliseconds(timer);
+    }
+    QSqlDatabase::removeDatabase(ConnectionName);
+    return duration;
+  }
+
+  double filter(const QString & databasePath, const QHash<QString, int> & ids,
+		QList<CBitSet> & results)
+  {
+    double duration = 0;
+    {
+      QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", ConnectionName);
+      db.setDatabaseName(databasePath);
+      if (!db.open())
+	return -1;
+
+      // as CLibrary::search()
+      QElapsedTimer timer;
+      timer.start();
+      results.clear();
+      for (int i = 0; i < queryCount; ++i)
+	{
+	  CSongQuery query(QString::fromUtf8(queries[i]));
+	  QVariantList bindings;
+	  QSqlQuery sqlQuery(db);
+	  sqlQuery.setForwardOnly(true);
+	  sqlQuery.prepare(QString("SELECT path FROM songs WHERE %1").arg(query.toSql(bindings)));
+	  foreach (const QVariant & value, bindings)
+	    sqlQuery.addBindValue(value);
+	  sqlQuery.exec();
+
+	  CBitSet songs(ids.size());
+	  while (sqlQuery.next())
+	    {
+	      int id = ids.value(sqlQuery.value(0).toString(), -1);
+	      if (id >= 0)
+		songs.setBit(id);
+	    }
+	  results << songs;
+	}
+      duration = milliseconds(timer);
+    }
+    QSqlDatabase::removeDatabase(ConnectionName);
+    return duration;
+  }
+
+  double sort(const QVector<CSong> & songs, QVector<int> & ranks)
+  {
+    QVector<int> ids(songs.size());
+    for (int id = 0; id < ids.size(); ++id)
+      ids[id] = id;
+
+    QElapsedTimer timer;
+    timer.start();
+    CLibrary::sortSongs(songs, ids);
+    double duration = milliseconds(timer);
+
+    ranks.resize(ids.size());
+    for (int rank = 0; rank < ids.size(); ++rank)
+      ranks[ids[rank]] = rank;
+    return duration;
+  }
+
+  // select all, refine with the filters, invert and list the paths of
+  // the selection in library order, as the build does
+  double select(const QVector<CSong> & songs, const QVector<int> & ranks,
+		const QList<CBitSet> & filters)
+  {
+    QElapsedTimer timer;
+    timer.start();
+
+    CBitSet selection(songs.size());
+    selection.fill(true);
+    for (int i = 0; i < filters.size(); ++i)
+      {
+	if (i % 2)
+	  selection.subtract(filters[i]);
+	else
+	  selection |= filters[i];
+      }
+    selection.invert();
+
+    QVector<int> ordered;
+    ordered.reserve(selection.count());
+    for (int id = selection.nextSetBit(0); id >= 0; id = selection.nextSetBit(id + 1))
+      ordered.append(id);
+    QVector<int> byRank(songs.size(), -1);
+    foreach (int id, ordered)
+      byRank[ranks[id]] = id;
+    QStringList paths;
+    foreach (int id, byRank)
+      if (id >= 0)
+	paths << songs[id].path;
+
+    return milliseconds(timer);
+  }
+
+  double scan(const QStringList & paths)
+  {
+    QElapsedTimer timer;
+    timer.start();
+    QtConcurrent::blockingMapped< QList< QList<CLyricsHit> > >(paths, LyricsScan("mala"));
+    return milliseconds(timer);
+  }
+
+  //----------------------------------------------------------------------------
+  // ingest before the arenas, as reference for the allocations
+
+  bool referenceParseSong(const QString & path, CSong & song)
+  {
+    QString fileStr;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+      return false;
+    QTextStream stream (&file);
+    fileStr = stream.readAll();
+    file.close();
+
+    QRegExp rx1("by=([^[,|\\]]+)");
+    rx1.indexIn(fileStr);
+    song.artist = SbUtils::latexToUtf8(rx1.cap(1));
+    QRegExp rx2("beginsong\\{([^[\\}]+)");
+    rx2.indexIn(fileStr);
+    song.title = SbUtils::latexToUtf8(rx2.cap(1));
+    QRegExp rx3(",album=([^[\\]]+)");
+    rx3.indexIn(fileStr);
+    song.album = SbUtils::latexToUtf8(rx3.cap(1));
+    QRegExp rx4("\\\\lilypond");
+    song.lilypond = QBool(rx4.indexIn(fileStr) > -1);
+    QRegExp rx5("selectlanguage\\{([^[\\}]+)");
+    rx5.indexIn(fileStr);
+    song.lang = rx5.cap(1);
+    QRegExp rx6(",cov=([^[,]+)");
+    rx6.indexIn(fileStr);
+    QString coverName = rx6.cap(1);
+    QString coverPath = path;
+    coverPath.replace( QRegExp("\\/([^\\/]*).sg"), QString() );
+    song.cover = QString("%1/%2.jpg").arg(coverPath).arg(coverName);
+    CLibrary::resolveCover(song);
+
+    song.path = path;
+    return true;
+  }
+
+  QSqlRecord referenceSongRecord(const CSong & song)
+  {
+    QSqlRecord record;
+    QSqlField f1("artist", QVariant::String);
+    QSqlField f2("title", QVariant::String);
+    QSqlField f3("lilypond", QVariant::Bool);
+    QSqlField f4("path", QVariant::String);
+    QSqlField f5("album", QVariant::String);
+    QSqlField f6("cover", QVariant::String);
+    QSqlField f7("lang", QVariant::String);
+    QSqlField f8("cover_path", QVariant::String);
+    QSqlField f9("has_cover", QVariant::Bool);
+
+    f1.setValue(QVariant(song.artist));
+    f2.setValue(QVariant(song.title));
+    f3.setValue(QVariant(song.lilypond));
+    f4.setValue(QVariant(song.path));
+    f5.setValue(QVariant(song.album));
+    f6.setValue(QVariant(song.cover));
+    f7.setValue(QVariant(song.lang));
+    f8.setValue(QVariant(song.coverPath));
+    f9.setValue(QVariant(song.hasCover));
+
+    record.append(f1);
+    record.append(f2);
+    record.append(f3);
+    record.append(f4);
+    record.append(f5);
+    record.append(f6);
+    record.append(f7);
+    record.append(f8);
+    record.append(f9);
+    return record;
+  }
+
+#if defined(SB_COUNT_ALLOCATIONS)
+  long allocations()
+  {
+    return __sync_fetch_and_add(&allocationCount, 0);
+  }
+
+  double perSong(long count, int songs)
+  {
+    return songs ? double(count) / songs : 0;
+  }
+
+  // allocations per song of reading then storing the songs, with the
+  // reference and with the ingest
+  QList<Allocations> countAllocations(const QStringList & paths, const QString & databasePath)
+  {
+    QList<Allocations> counts;
+    Allocations read = { "read", paths.size(), 0, 0 };
+    Allocations store = { "store", paths.size(), 0, 0 };
+
+    QVector<CSong> songs(paths.size());
+    long start = allocations();
+    for (int i = 0; i < paths.size(); ++i)
+      referenceParseSong(paths[i], songs[i]);
+    read.reference = perSong(allocations() - start, paths.size());
+
+    songs = QVector<CSong>(paths.size());
+    {
+      CStringPool strings;
+      CIngestArena arena(&strings);
+      start = allocations();
+      for (int i = 0; i < paths.size(); ++i)
+	arena.read(paths[i], songs[i]);
+      read.current = perSong(allocations() - start, paths.size());
+    }
+
+    for (int pass = 0; pass < 2; ++pass)
+      {
+	QFile::remove(databasePath);
+	{
+	  QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", ConnectionName);
+	  db.setDatabaseName(databasePath);
+	  if (!db.open())
+	    break;
+	  CLibrary::createTables(db);
+
+	  db.transaction();
+	  if (pass == 0)
+	    {
+	      QSqlTableModel model(0, db);
+	      model.setTable("songs");
+	      model.setEditStrategy(QSqlTableModel::OnManualSubmit);
+	      start = allocations();
+	      foreach (const CSong & song, songs)
+		model.insertRecord(-1, referenceSongRecord(song));
+	      model.submitAll();
+	      store.reference = perSong(allocations() - start, songs.size());
+	    }
+	  else
+	    {
+	      CSongWriter writer(db);
+	      start = allocations();
+	      foreach (const CSong & song, songs)
+		writer.insert(song);
+	      store.current = perSong(allocations() - start, songs.size());
+	    }
+	  db.commit();
+	}
+	QSqlDatabase::removeDatabase(ConnectionName);
+      }
+    QFile::remove(databasePath);
+
+    counts << read << store;
+    return counts;
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+  bool writeResults(QTextStream & out, const QList<Result> & results,
+		    const QList<Allocations> & counts,
+		    const CSyntheticLibrary::Parameters & parameters, int repeat)
+  {
+    out << "{\n  \"benchmark\": \"songbook-bench\",\n"
+	<< "  \"threads\": " << QThread::idealThreadCount() << ",\n"
+	<< "  \"repeat\": " << repeat << ",\n"
+	<< "  \"parameters\": {\"songs_per_artist\": " << parameters.songsPerArtist
+	<< ", \"songs_per_album\": " << parameters.songsPerAlbum
+	<< ", \"cover_ratio\": " << parameters.coverRatio
+	<< ", \"lilypond_ratio\": " << parameters.lilypondRatio
+	<< ", \"languages\": {";
+    for (int i = 0; i < parameters.languages.size(); ++i)
+      out << (i ? ", " : "") << jsonString(parameters.languages[i].first)
+	  << ": " << parameters.languages[i].second;
+    out << "}},\n  \"results\": [";
+
+    for (int i = 0; i < results.size(); ++i)
+      {
+	const Result & result = results[i];
+	out << (i ? ",\n" : "\n") << "    {\"name\": " << jsonString(result.name)
+	    << ", \"songs\": " << result.songs
+	    << ", \"median_ms\": " << QString::number(result.median(), 'f', 3)
+	    << ", \"min_ms\": " << QString::number(result.minimum(), 'f', 3) << "}";
+      }
+    out << "\n  ],\n  \"allocations_per_song\": [";
+
+    for (int i = 0; i < counts.size(); ++i)
+      {
+	const Allocations & count = counts[i];
+	out << (i ? ",\n" : "\n") << "    {\"name\": " << jsonString(count.name)
+	    << ", \"songs\": " << count.songs
+	    << ", \"reference\": " << QString::number(count.reference, 'f', 1)
+	    << ", \"current\": " << QString::number(count.current, 'f', 1) << "}";
+      }
+    out << "\n  ]\n}\n";
+    out.flush();
+    return out.status() == QTextStream::Ok;
+  }
+
+  // returns the number of regressions, or -1 if the baseline is unreadable
+  int compare(const QList<Result> & results, const QString & filename,
+	      double tolerance, QTextStream & log)
+  {
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+      return -1;
+
+    QScriptEngine engine;
+    QScriptValue baseline = engine.evaluate(QString("(%1)").arg(QString::fromUtf8(file.readAll())));
+    if (engine.hasUncaughtException() || !baseline.property("results").isArray())
+      return -1;
+
+    QHash<QString, double> medians;
+    QScriptValue values = baseline.property("results");
+    int length = values.property("length").toInt32();
+    for (int i = 0; i < length; ++i)
+      {
+	QScriptValue value = values.property(i);
+	medians.insert(key(value.property("name").toString(), value.property("songs").toInt32()),
+		       value.property("median_ms").toNumber());
+      }
+
+    int regressions = 0;
+    foreach (const Result & result, results)
+      {
+	QString name = key(result.name, result.songs);
+	if (!medians.contains(name))
+	  continue;
+
+	double reference = medians.value(name);
+	double current = result.median();
+	bool regression = current > reference * (1 + tolerance)
+	  && current - reference > MinimalDifference;
+	if (regression)
+	  ++regressions;
+	log << QString("%1 %2 ms, baseline %3 ms%4\n")
+	  .arg(name, -24).arg(current, 10, 'f', 2).arg(reference, 10, 'f', 2)
+	  .arg(regression ? "  REGRESSION" : "");
+      }
+    log.flush();
+    return regressions;
+  }
+}
+
+//******************************************************************************
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  QStringList arguments = app.arguments();
+  QTextStream log(stderr);
+
+  // nothing to compare against, see make bench-baseline
+  QString baseline = argument(arguments, "--baseline");
+  if (!baseline.isEmpty() && !QFile::exists(baseline))
+    {
+      log << "no baseline " << baseline << ", skipped\n";
+      return 77;
+    }
+
+  QList<int> sizes;
+  foreach (const QString & size,
+	   argument(arguments, "--sizes", "1000,10000,100000").split(',', QString::SkipEmptyParts))
+    sizes << size.toInt();
+  int repeat = qMax(1, argument(arguments, "--repeat", "3").toInt());
+
+  CSyntheticLibrary::Parameters parameters;
+  parameters.songsPerArtist =
+    argument(arguments, "--songs-per-artist", QString::number(parameters.songsPerArtist)).toInt();
+  parameters.songsPerAlbum =
+    argument(arguments, "--songs-per-album", QString::number(parameters.songsPerAlbum)).toInt();
+  parameters.coverRatio =
+    argument(arguments, "--covers", QString::number(parameters.coverRatio)).toDouble();
+  parameters.lilypondRatio =
+    argument(arguments, "--lilypond", QString::number(parameters.lilypondRatio)).toDouble();
+  QString languages = argument(arguments, "--languages");
+  if (!languages.isEmpty())
+    {
+      parameters.languages.clear();
+      foreach (const QString & language, languages.split(',', QString::SkipEmptyParts))
+	parameters.languages << qMakePair(language.section(':', 0, 0),
+					  language.section(':', 1, 1).toDouble());
+    }
+
+  QString root = QString("%1/songbook-bench-%2").arg(QDir::tempPath()).arg(app.applicationPid());
+  QList<Result> results;
+  QList<Allocations> counts;
+  foreach (int size, sizes)
+    {
+      QString directory = QString("%1/%2").arg(root).arg(size);
+      CSyntheticLibrary library(QString("%1/songbook").arg(directory), parameters);
+      log << "generating " << size << " songs\n";
+      log.flush();
+      if (!library.generate(size))
+	{
+	  log << "unable to generate the library in " << library.workingPath() << "\n";
+	  CSyntheticLibrary::removeDirectory(root);
+	  return 2;
+	}
+
+      Result walkResult = { "walk", size, QList<double>() };
+      Result parseResult = { "parse", size, QList<double>() };
+      Result insertResult = { "insert", size, QList<double>() };
+      Result filterResult = { "filter", size, QList<double>() };
+      Result sortResult = { "sort", size, QList<double>() };
+      Result selectResult = { "selection", size, QList<double>() };
+      Result scanResult = { "lyrics scan", size, QList<double>() };
+
+      QStringList paths;
+      QVector<CSong> songs;
+      QHash<QString, int> ids;
+      QList<CBitSet> filters;
+      QVector<int> ranks;
+      QString databasePath = QString("%1/songs.db").arg(directory);
+      for (int run = 0; run < repeat; ++run)
+	{
+	  log << "  run " << run + 1 << "/" << repeat << "\n";
+	  log.flush();
+	  walkResult.times << walk(library.workingPath(), paths);
+	  parseResult.times << parse(paths, songs);
+	  insertResult.times << insert(databasePath, songs);
+
+	  ids.clear();
+	  for (int id = 0; id < songs.size(); ++id)
+	    ids.insert(songs[id].path, id);
+	  filterResult.times << filter(databasePath, ids, filters);
+	  sortResult.times << sort(songs, ranks);
+	  selectResult.times << select(songs, ranks, filters);
+	  scanResult.times << scan(paths);
+	}
+
+      results << walkResult << parseResult << insertResult << filterResult
+	      << sortResult << selectResult << scanResult;
+
+#if defined(SB_COUNT_ALLOCATIONS)
+      QList<Allocations> sizeCounts =
+	countAllocations(paths, QString("%1/allocations.db").arg(directory));
+      foreach (const Allocations & count, sizeCounts)
+	log << QString("  %1: %2 allocations per song, %3 before\n")
+	  .arg(count.name).arg(count.current, 0, 'f', 1).arg(count.reference, 0, 'f', 1);
+      counts << sizeCounts;
+#endif
+      CSyntheticLibrary::removeDirectory(directory);
+    }
+  CSyntheticLibrary::removeDirectory(root);
+
+  QString output = argument(arguments, "--output");
+  if (output.isEmpty())
+    {
+      QTextStream out(stdout);
+      writeResults(out, results, counts, parameters, repeat);
+    }
+  else
+    {
+      QFile file(output);
+      if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+	{
+	  log << "unable to write " << output << "\n";
+	  return 2;
+	}
+      QTextStream out(&file);
+      writeResults(out, results, counts, parameters, repeat);
+    }
+
+  if (baseline.isEmpty())
+    return 0;
+
+  double tolerance = argument(arguments, "--tolerance", "0.25").toDouble();
+  int regressions = compare(results, baseline, tolerance, log);
+  if (regressions < 0)
+    {
+      log << "unable to read the baseline " << baseline << "\n";
+      return 2;
+    }
+  return regressions ? 1 : 0;
+}
+//******************************************************************************
@@ -0,0 +1,122 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+// Time to first paint of the main window on a synthetic library.
+//
+// usage: songbook-startup-bench [--songs N] [--runs N] [--keep]
+//
+// The application runs in a temporary home directory so that the
+// settings, the database and the caches of the user are not used. The
+// first run fills an empty database, the next runs load it.
+
+#include <QApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QTimer>
+
+#include "mainwindow.hh"
+#include "startup-profile.hh"
+#include "synthetic-library.hh"
+
+namespace
+{
+  // a run not painted by then is reported as failed
+  const int Timeout = 120000;
+
+  int intArgument(int argc, char *argv[], const char *name, int value)
+  {
+    for (int i = 1; i + 1 < argc; ++i)
+      if (!qstrcmp(argv[i], name))
+	return QString(argv[i + 1]).toInt();
+    return value;
+  }
+
+  bool hasArgument(int argc, char *argv[], const char *name)
+  {
+    for (int i = 1; i < argc; ++i)
+      if (!qstrcmp(argv[i], name))
+	return true;
+    return false;
+  }
+}
+
+//******************************************************************************
+int main(int argc, char *argv[])
+{
+  int songs = intArgument(argc, argv, "--songs", 5000);
+  int runs = qMax(1, intArgument(argc, argv, "--runs", 3));
+  bool keep = hasArgument(argc, argv, "--keep");
+
+  // must be set before the settings and the database are located
+  QString home = QString("%1/songbook-startup-bench-%2")
+    .arg(QDir::tempPath()).arg(QCoreApplication::applicationPid());
+  QDir().mkpath(home);
+  qputenv("HOME", QFile::encodeName(home));
+  qputenv("XDG_CONFIG_HOME", QFile::encodeName(home + "/.config"));
+  qputenv("XDG_CACHE_HOME", QFile::encodeName(home + "/.cache"));
+
+  QApplication app(argc, argv);
+  Q_INIT_RESOURCE(songbook);
+  QCoreApplication::setOrganizationName("Patacrep");
+  QCoreApplication::setOrganizationDomain("patacrep.com");
+  QCoreApplication::setApplicationName("songbook-client");
+  QTextCodec::setCodecForCStrings(QTextCodec::codecForName("UTF-8"));
+
+  QTextStream out(stdout);
+  CSyntheticLibrary library(QString("%1/songbook").arg(home));
+  if (!library.generate(songs))
+    {
+      out << "unable to generate the library in " << library.workingPath() << "\n";
+      CSyntheticLibrary::removeDirectory(home);
+      return 1;
+    }
+  out << songs << " songs in " << library.workingPath() << "\n";
+
+  int status = 0;
+  CStartupProfile *profile = CStartupProfile::instance();
+  for (int run = 0; run < runs; ++run)
+    {
+      profile->start();
+      CMainWindow *mainWindow = new CMainWindow;
+      profile->watchFirstPaint(mainWindow);
+
+      QEventLoop loop;
+      QObject::connect(profile, SIGNAL(firstPainted()), &loop, SLOT(quit()));
+      QTimer::singleShot(Timeout, &loop, SLOT(quit()));
+      mainWindow->show();
+      loop.exec();
+
+      out << "run " << run + 1 << (run ? " (warm database)" : " (empty database)") << "\n";
+      if (profile->firstPaint() < 0)
+	{
+	  out << "  no paint within " << Timeout << " ms\n";
+	  status = 1;
+	}
+      profile->report(out);
+      delete mainWindow;
+    }
+
+  if (keep)
+    out << "kept " << home << "\n";
+  else
+    CSyntheticLibrary::removeDirectory(home);
+  return status;
+}
+//******************************************************************************
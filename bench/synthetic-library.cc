@@ -0,0 +1,257 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "synthetic-library.hh"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QImage>
+#include <QTextStream>
+
+namespace
+{
+  const char *syllables[] = {
+    "ba", "be", "bo", "ca", "ce", "da", "de", "fa", "ga", "la",
+    "le", "lo", "ma", "me", "mi", "na", "no", "pa", "ra", "re",
+    "ri", "sa", "se", "ta", "to", "va", "vi", "\\'e", "\\`a", "\\c{c}a"
+  };
+  const int syllableCount = sizeof(syllables) / sizeof(syllables[0]);
+
+  // whether item \a index is one of those spread evenly at \a ratio
+  bool spread(int index, double ratio)
+  {
+    return int((index + 1) * ratio) != int(index * ratio);
+  }
+}
+
+//------------------------------------------------------------------------------
+CSyntheticLibrary::Parameters::Parameters()
+  : songsPerArtist(48)
+  , songsPerAlbum(12)
+  , coverRatio(0.25)
+  , lilypondRatio(0.1)
+  , languages()
+{
+  languages << qMakePair(QString("english"), 0.4)
+	    << qMakePair(QString("french"), 0.4)
+	    << qMakePair(QString("spanish"), 0.1)
+	    << qMakePair(QString("portuguese"), 0.1);
+}
+
+//------------------------------------------------------------------------------
+CSyntheticLibrary::CSyntheticLibrary(const QString & AWorkingPath,
+				     const Parameters & AParameters)
+  : m_workingPath(AWorkingPath)
+  , m_parameters(AParameters)
+  , m_songs()
+  , m_seed(0)
+{}
+//------------------------------------------------------------------------------
+CSyntheticLibrary::~CSyntheticLibrary()
+{}
+//------------------------------------------------------------------------------
+QString CSyntheticLibrary::workingPath() const
+{
+  return m_workingPath;
+}
+//------------------------------------------------------------------------------
+QStringList CSyntheticLibrary::songs() const
+{
+  return m_songs;
+}
+//------------------------------------------------------------------------------
+QString CSyntheticLibrary::word(int count)
+{
+  QString word;
+  for (int i = 0; i < count; ++i)
+    {
+      // linear congruential generator, identical on every platform
+      m_seed = m_seed * 1103515245u + 12345u;
+      word += syllables[(m_seed >> 16) % syllableCount];
+    }
+  word[0] = word[0].toUpper();
+  return word;
+}
+//------------------------------------------------------------------------------
+QString CSyntheticLibrary::language(int index) const
+{
+  // a fixed permutation of the songs spreads the languages
+  double position = ((quint32(index) * 2654435761u) % 10000) / 10000.0;
+  double total = 0;
+  for (int i = 0; i < m_parameters.languages.size(); ++i)
+    {
+      total += m_parameters.languages[i].second;
+      if (position < total)
+	return m_parameters.languages[i].first;
+    }
+  return QString();
+}
+//------------------------------------------------------------------------------
+bool CSyntheticLibrary::generate(int count)
+{
+  m_songs.clear();
+  m_seed = 42;
+
+  QDir dir;
+  if (!dir.mkpath(QString("%1/songs").arg(m_workingPath)))
+    return false;
+
+  const int perArtist = qMax(1, m_parameters.songsPerArtist);
+  const int perAlbum = qBound(1, m_parameters.songsPerAlbum, perArtist);
+
+  QString artist;
+  QString album;
+  QString albumPath;
+  int artistIndex = -1;
+  int albumIndex = -1;
+  bool cover = false;
+  for (int i = 0; i < count; ++i)
+    {
+      if (i % perArtist == 0)
+	{
+	  artist = QString("%1 %2").arg(word(2)).arg(word(3));
+	  ++artistIndex;
+	}
+
+      if (i % perArtist % perAlbum == 0)
+	{
+	  album = word(3);
+	  albumPath = QString("%1/songs/artist-%2/album-%3")
+	    .arg(m_workingPath).arg(artistIndex).arg(++albumIndex);
+	  if (!dir.mkpath(albumPath))
+	    return false;
+
+	  cover = spread(albumIndex, m_parameters.coverRatio);
+	  if (cover && !writeCover(QString("%1/cover.jpg").arg(albumPath)))
+	    return false;
+	}
+
+      QString title = QString("%1 %2").arg(word(2)).arg(word(2 + i % 3));
+      QString path = QString("%1/song-%2.sg").arg(albumPath).arg(i);
+      if (!writeSong(path, artist, album, title, cover))
+	return false;
+      m_songs << path;
+    }
+
+  return writeTemplate();
+}
+//------------------------------------------------------------------------------
+bool CSyntheticLibrary::writeSong(const QString & path, const QString & artist,
+				  const QString & album, const QString & title,
+				  bool cover)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return false;
+
+  QTextStream out(&file);
+  out.setCodec("UTF-8");
+  QString lang = language(m_songs.size());
+  if (!lang.isEmpty())
+    out << "\\selectlanguage{" << lang << "}\n";
+  // the cover comes before the album, which ends the options
+  out << "\\beginsong{" << title << "}[by=" << artist;
+  if (cover)
+    out << ",cov=cover";
+  out << ",album=" << album << "]\n";
+  if (spread(m_songs.size(), m_parameters.lilypondRatio))
+    out << "\\lilypond{song.ly}\n";
+
+  for (int verse = 0; verse < 4; ++verse)
+    {
+      out << "\\beginverse\n";
+      for (int line = 0; line < 4; ++line)
+	out << "\\[G]" << word(3) << " " << word(2) << " \\[C]" << word(4) << "\n";
+      out << "\\endverse\n";
+    }
+  out << "\\endsong\n";
+  return out.status() == QTextStream::Ok;
+}
+//------------------------------------------------------------------------------
+bool CSyntheticLibrary::writeCover(const QString & path)
+{
+  QImage image(256, 256, QImage::Format_RGB32);
+  image.fill(qRgb((m_seed >> 8) & 0xff, (m_seed >> 16) & 0xff, m_seed & 0xff));
+  return image.save(path, "JPG");
+}
+//------------------------------------------------------------------------------
+bool CSyntheticLibrary::writeTemplate()
+{
+  QDir dir;
+  if (!dir.mkpath(QString("%1/templates").arg(m_workingPath)))
+    return false;
+
+  QFile file(QString("%1/templates/patacrep.tmpl").arg(m_workingPath));
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return false;
+
+  QTextStream out(&file);
+  out << "%%:[\n"
+      << "%%:{\"name\":\"title\", \"description\":\"Title\", \"type\":\"string\", \"default\":\"Benchmark\"},\n"
+      << "%%:{\"name\":\"author\", \"description\":\"Author\", \"type\":\"string\"},\n"
+      << "%%:{\"name\":\"mainfontsize\", \"description\":\"Font Size\", \"type\":\"font\", \"default\":\"10\"},\n"
+      << "%%:{\"name\":\"booktype\", \"description\":\"Type\", \"type\":\"flag\", "
+      << "\"values\":[\"chorded\", \"lyric\"], \"default\":[\"chorded\"]}\n"
+      << "%%:]\n";
+  return out.status() == QTextStream::Ok;
+}
+//------------------------------------------------------------------------------
+QString CSyntheticLibrary::writeSongbook(const QString & filename, int count) const
+{
+  QString path = QString("%1/%2").arg(m_workingPath).arg(filename);
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return QString();
+
+  // songs are relative to the songs directory, see CMainWindow::open()
+  QString songsPath = QString("%1/songs/").arg(m_workingPath);
+  QStringList songs = m_songs.mid(0, count);
+  songs.replaceInStrings(songsPath, QString());
+
+  QTextStream out(&file);
+  out << "{\n\"template\" : \"patacrep.tmpl\",\n"
+      << "\"title\" : \"Benchmark\",\n"
+      << "\"songs\" : [\n    \"" << songs.join("\",\n    \"") << "\"\n  ]\n}\n";
+  if (out.status() != QTextStream::Ok)
+    return QString();
+  return path;
+}
+//------------------------------------------------------------------------------
+bool CSyntheticLibrary::remove()
+{
+  return removeDirectory(m_workingPath);
+}
+//------------------------------------------------------------------------------
+bool CSyntheticLibrary::removeDirectory(const QString & path)
+{
+  QDir dir(path);
+  if (!dir.exists())
+    return true;
+
+  bool ok = true;
+  foreach (const QFileInfo & info,
+	   dir.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System
+			     | QDir::NoDotAndDotDot))
+    {
+      if (info.isDir() && !info.isSymLink())
+	ok = removeDirectory(info.absoluteFilePath()) && ok;
+      else
+	ok = QFile::remove(info.absoluteFilePath()) && ok;
+    }
+  return dir.rmdir(path) && ok;
+}
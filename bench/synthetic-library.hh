@@ -0,0 +1,96 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file synthetic-library.hh
+ *
+ * Generation of a reproducible songs library for the benchmarks.
+ *
+ * The same parameters always give the same files: artists, albums
+ * and titles are drawn from fixed syllables, some of them with LaTeX
+ * accents, and the covers, lilypond snippets and languages are spread
+ * evenly according to their ratios.
+ *
+ */
+#ifndef __SYNTHETIC_LIBRARY_HH__
+#define __SYNTHETIC_LIBRARY_HH__
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QPair>
+
+/** \class CSyntheticLibrary "synthetic-library.hh"
+ * \brief CSyntheticLibrary writes a working directory of generated songs
+ */
+class CSyntheticLibrary
+{
+public:
+  struct Parameters
+  {
+    Parameters();
+
+    /// Artist fan-out: number of songs of each artist.
+    int songsPerArtist;
+    int songsPerAlbum;
+    /// Ratio of the albums having a cover.
+    double coverRatio;
+    /// Ratio of the songs including a lilypond score.
+    double lilypondRatio;
+    /// Languages with their ratio of the songs.
+    QList< QPair<QString, double> > languages;
+  };
+
+  CSyntheticLibrary(const QString & workingPath,
+		    const Parameters & parameters = Parameters());
+  ~CSyntheticLibrary();
+
+  QString workingPath() const;
+
+  /// Writes \a count songs and the default template, returns false
+  /// if a file could not be written.
+  bool generate(int count);
+
+  /// Paths of the songs written by generate().
+  QStringList songs() const;
+
+  /// Writes the songbook \a filename of the working directory with
+  /// the first \a count songs, returns its path or an empty string.
+  QString writeSongbook(const QString & filename, int count) const;
+
+  /// Removes the working directory and its content.
+  bool remove();
+
+  /// Removes \a path and its content.
+  static bool removeDirectory(const QString & path);
+
+private:
+  QString word(int syllables);
+  QString language(int index) const;
+  bool writeSong(const QString & path, const QString & artist,
+		 const QString & album, const QString & title, bool cover);
+  bool writeCover(const QString & path);
+  bool writeTemplate();
+
+  QString m_workingPath;
+  Parameters m_parameters;
+  QStringList m_songs;
+  quint32 m_seed;
+};
+
+#endif // __SYNTHETIC_LIBRARY_HH__
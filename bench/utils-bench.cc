@@ -0,0 +1,348 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+// Checks and microbenchmarks of the string kernels of SbUtils.
+//
+// usage: songbook-utils-bench [--length N] [--repeat N]
+//
+// latexToUtf8() and stringToFilename() are compared with the
+// implementations they replaced, kept below as references, on every
+// string of up to --length characters over an alphabet of the
+// characters they handle, and on one example of each table entry.
+// Both are then timed against their reference on song headers.
+// Exits with 1 on the first difference.
+//
+// The decoders handle more than the references did, so that:
+//  - latexToUtf8() must give the reference output whenever the
+//    reference decoded the whole string, that is left no backslash,
+//    except for \~ followed by a letter, now a tilde accent instead of
+//    a space followed by the letter;
+//  - stringToFilename() must give the reference output once the
+//    letters the reference did not transliterate are spelled in ASCII.
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRegExp>
+#include <QStringList>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QVector>
+
+#include "utils/utils.hh"
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // references
+
+  QString referenceLatexToUtf8(const QString & AString)
+  {
+    QString str(AString);
+    str.replace(QString("\\'e"), QString("é"));
+    str.replace(QString("\\`e"), QString("è"));
+    str.replace(QString("\\^e"), QString("ê"));
+    str.replace(QString("\\¨e"), QString("ë"));
+    str.replace(QString("\\¨i"), QString("ï"));
+    str.replace(QString("\\^i"), QString("î"));
+    str.replace(QString("\\^o"), QString("ô"));
+    str.replace(QString("\\`u"), QString("ù"));
+    str.replace(QString("\\`a"), QString("à"));
+    str.replace(QString("\\^a"), QString("â"));
+    str.replace(QString("\\&"), QString("&"));
+    str.replace(QString("\\~"), QString("~"));
+    str.replace(QString("\\,"), QString(" "));
+    str.replace(QString("~"), QString(" "));
+    str.replace(QString("\\dots"), QString("..."));
+    return str;
+  }
+
+  QString referenceStringToFilename(const QString & AString, const QString & sep)
+  {
+    QString str(AString);
+    QString item;
+    QStringList list = QStringList()
+      <<"é"<<"è"<<"ê"<<"ë";
+    foreach(item, list)
+      str.replace(item, QString("e"));
+
+    str.replace(QRegExp("(\\s+)|(\\W+)"), sep);
+
+    str.replace(QString("à"), QString("a"));
+    str.replace(QString("â"), QString("a"));
+    str.replace(QString("ï"), QString("i"));
+    str.replace(QString("î"), QString("i"));
+    str.replace(QString("ô"), QString("o"));
+    str.replace(QString("ù"), QString("u"));
+    return str;
+  }
+
+  //----------------------------------------------------------------------------
+  // one example of each entry of the tables, in UTF-8
+  struct Example
+  {
+    const char *input;
+    const char *expected;
+  };
+
+  const Example latexExamples[] = {
+    { "\\'a\\'c\\'e\\'i\\'n\\'o\\'s\\'u\\'y\\'z", "áćéíńóśúýź" },
+    { "\\'A\\'C\\'E\\'I\\'N\\'O\\'S\\'U\\'Y\\'Z", "ÁĆÉÍŃÓŚÚÝŹ" },
+    { "\\`a\\`e\\`i\\`o\\`u\\`A\\`E\\`I\\`O\\`U", "àèìòùÀÈÌÒÙ" },
+    { "\\^a\\^c\\^e\\^i\\^o\\^s\\^u\\^y", "âĉêîôŝûŷ" },
+    { "\\^A\\^C\\^E\\^I\\^O\\^S\\^U\\^Y", "ÂĈÊÎÔŜÛŶ" },
+    { "\\\"a\\\"e\\\"i\\\"o\\\"u\\\"y", "äëïöüÿ" },
+    { "\\\"A\\\"E\\\"I\\\"O\\\"U\\\"Y", "ÄËÏÖÜŸ" },
+    { "\\¨e\\¨i", "ëï" },
+    { "\\~a\\~i\\~n\\~o\\~u\\~A\\~I\\~N\\~O\\~U", "ãĩñõũÃĨÑÕŨ" },
+    { "\\c{c}\\c{e}\\c{s}\\c c\\c{C}\\c{E}\\c{S}", "çȩşçÇȨŞ" },
+    { "\\'{e}t\\'{E}\\^{\\i}le \\\"\\i", "étÉîle ï" },
+    { "c\\oe ur \\OE{}uvre \\ae\\AE{} \\aa\\AA{} \\o\\O{} \\l\\L{} \\ss{} \\i", "cœur Œuvre æÆ åÅ øØ łŁ ß ı" },
+    { "A\\~{}B~C\\,D \\& E\\dots", "A {}B C D & E..." },
+    { "\\'x \\c{x} \\oeuvre \\~e \\", "\\'x \\c{x} \\oeuvre  e \\" }
+  };
+  const int latexExampleCount = sizeof(latexExamples) / sizeof(latexExamples[0]);
+
+  const Example filenameExamples[] = {
+    { "Les Champs-Élysées", "Les_Champs_Elysees" },
+    { "Ça plane pour moi", "Ca_plane_pour_moi" },
+    { "Cœur de pirate", "Coeur_de_pirate" },
+    { "Straße, Øresund & Þór", "Strasse_Oresund__THor" },
+    { "À l'ombre  -  ïle", "A_l_ombre__ile" }
+  };
+  const int filenameExampleCount = sizeof(filenameExamples) / sizeof(filenameExamples[0]);
+
+  //----------------------------------------------------------------------------
+  // enumerates the strings of up to length characters over alphabet
+  class CStrings
+  {
+  public:
+    CStrings(const QString & alphabet, int length)
+      : m_alphabet(alphabet)
+      , m_digits()
+      , m_length(length)
+    {}
+
+    bool next(QString & str)
+    {
+      int i = 0;
+      for (; i < m_digits.size(); ++i)
+	{
+	  if (++m_digits[i] < m_alphabet.size())
+	    break;
+	  m_digits[i] = 0;
+	}
+      if (i == m_digits.size())
+	{
+	  if (m_digits.size() == m_length)
+	    return false;
+	  m_digits.append(0);
+	}
+
+      str.resize(m_digits.size());
+      for (int j = 0; j < m_digits.size(); ++j)
+	str[j] = m_alphabet[m_digits[j]];
+      return true;
+    }
+
+  private:
+    QString m_alphabet;
+    QVector<int> m_digits;
+    int m_length;
+  };
+
+  bool isExpectedLatexDifference(const QString & str, const QString & reference)
+  {
+    static const QRegExp tildeAccent("\\\\~[A-Za-z{\\\\]");
+    return reference.contains('\\') || str.contains(tildeAccent);
+  }
+
+  QString spellNewLetters(const QString & str)
+  {
+    static const QString referenceLetters = QString::fromUtf8("éèêëàâïîôù");
+    QString result;
+    foreach (const QChar & c, str)
+      {
+	if (c.isLetter() && !referenceLetters.contains(c))
+	  result += SbUtils::stringToFilename(QString(c), QString());
+	else
+	  result += c;
+      }
+    return result;
+  }
+
+  QString quoted(const QString & str)
+  {
+    QString escaped(str);
+    escaped.replace("\t", "\\t");
+    return QString("\"%1\"").arg(escaped);
+  }
+
+  //----------------------------------------------------------------------------
+  bool checkLatex(int length, QTextStream & log)
+  {
+    for (int i = 0; i < latexExampleCount; ++i)
+      {
+	QString text = SbUtils::latexToUtf8(QString::fromUtf8(latexExamples[i].input));
+	if (text != QString::fromUtf8(latexExamples[i].expected))
+	  {
+	    log << "latexToUtf8(" << quoted(QString::fromUtf8(latexExamples[i].input))
+		<< ") gives " << quoted(text) << ", expected "
+		<< quoted(QString::fromUtf8(latexExamples[i].expected)) << "\n";
+	    return false;
+	  }
+      }
+
+    QString alphabet = QString::fromUtf8("\\'`^\"¨~&,{}eiacondts ");
+    CStrings strings(alphabet, length);
+    QString str;
+    int count = 0;
+    while (strings.next(str))
+      {
+	QString text = SbUtils::latexToUtf8(str);
+	QString reference = referenceLatexToUtf8(str);
+	if (text != reference && !isExpectedLatexDifference(str, reference))
+	  {
+	    log << "latexToUtf8(" << quoted(str) << ") gives " << quoted(text)
+		<< ", the reference " << quoted(reference) << "\n";
+	    return false;
+	  }
+	++count;
+      }
+    log << "latexToUtf8: " << count << " strings checked\n";
+    return true;
+  }
+
+  bool checkFilename(int length, QTextStream & log)
+  {
+    for (int i = 0; i < filenameExampleCount; ++i)
+      {
+	QString filename = SbUtils::stringToFilename(QString::fromUtf8(filenameExamples[i].input), "_");
+	if (filename != QString::fromUtf8(filenameExamples[i].expected))
+	  {
+	    log << "stringToFilename(" << quoted(QString::fromUtf8(filenameExamples[i].input))
+		<< ") gives " << quoted(filename) << ", expected "
+		<< quoted(QString::fromUtf8(filenameExamples[i].expected)) << "\n";
+	    return false;
+	  }
+      }
+
+    // space, punctuation, word characters, letters transliterated by
+    // the reference or not, a sign and a combining accent
+    QString alphabet = QString::fromUtf8(" \t-_.aZ1éàïçœØ×\xcc\x81");
+    CStrings strings(alphabet, length);
+    QString str;
+    int count = 0;
+    while (strings.next(str))
+      {
+	QString filename = SbUtils::stringToFilename(str, "_");
+	QString reference = referenceStringToFilename(spellNewLetters(str), "_");
+	if (filename != reference)
+	  {
+	    log << "stringToFilename(" << quoted(str) << ") gives " << quoted(filename)
+		<< ", the reference " << quoted(reference) << "\n";
+	    return false;
+	  }
+	++count;
+      }
+    log << "stringToFilename: " << count << " strings checked\n";
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // headers as found in the songs, in ns per string
+  QStringList headers()
+  {
+    QStringList list;
+    list << "Les Champs-\\'Elys\\'ees"
+	 << "L'\\'et\\'e indien"
+	 << "La Boh\\`eme"
+	 << "Ça plane pour moi"
+	 << "No\\\"el~blanc"
+	 << "Fran\\c{c}ois Valéry"
+	 << "Le Ch\\^ateau de ma m\\`ere"
+	 << "Tom Waits"
+	 << "Rock \\& Roll\\dots"
+	 << "C\\oe ur de pirate";
+    return list;
+  }
+
+  template <typename Function>
+  double nsecsPerString(Function function, const QStringList & strings, int repeat)
+  {
+    QElapsedTimer timer;
+    timer.start();
+    int length = 0;
+    for (int i = 0; i < repeat; ++i)
+      foreach (const QString & str, strings)
+	length += function(str).size();
+    double nsecs = double(timer.nsecsElapsed());
+    // keeps the calls from being optimised out
+    if (length < 0)
+      qDebug() << length;
+    return nsecs / (double(repeat) * strings.size());
+  }
+
+  QString filename(const QString & str)
+  {
+    return SbUtils::stringToFilename(str, "_");
+  }
+
+  QString referenceFilename(const QString & str)
+  {
+    return referenceStringToFilename(str, "_");
+  }
+
+  QString argument(const QStringList & arguments, const QString & name,
+		   const QString & value = QString())
+  {
+    int index = arguments.indexOf(name);
+    if (index < 0 || index + 1 >= arguments.size())
+      return value;
+    return arguments[index + 1];
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  QTextCodec::setCodecForCStrings(QTextCodec::codecForName("UTF-8"));
+  QStringList arguments = app.arguments();
+  QTextStream log(stderr);
+  QTextStream out(stdout);
+
+  int length = qMax(1, argument(arguments, "--length", "4").toInt());
+  int repeat = qMax(1, argument(arguments, "--repeat", "20000").toInt());
+
+  if (!checkLatex(length, log) || !checkFilename(length, log))
+    return 1;
+
+  QStringList strings = headers();
+  QStringList decoded;
+  foreach (const QString & str, strings)
+    decoded << SbUtils::latexToUtf8(str);
+
+  out << "kernel\treference (ns)\tdecoder (ns)\n";
+  out << "latexToUtf8\t"
+      << nsecsPerString(referenceLatexToUtf8, strings, repeat) << "\t"
+      << nsecsPerString(SbUtils::latexToUtf8, strings, repeat) << "\n";
+  out << "stringToFilename\t"
+      << nsecsPerString(referenceFilename, decoded, repeat) << "\t"
+      << nsecsPerString(filename, decoded, repeat) << "\n";
+  return 0;
+}
@@ -19,6 +19,8 @@
 #include "build-engine.hh"
 #include "mainwindow.hh"
 #include "highlighter.hh"
+#include "ui-update-scheduler.hh"
+#include "tracer.hh"
 
 CBuildEngine::CBuildEngine(CMainWindow* AParent)
   : QWidget()
@@ -26,6 +28,7 @@ CBuildEngine::CBuildEngine(CMainWindow* AParent)
   , m_statusActionMessage(tr("Processing"))
   , m_statusSuccessMessage(tr("Success!"))
   , m_statusErrorMessage(tr("Error!"))
+  , m_traceStart(-1)
 {
   m_parent = AParent;
   m_workingPath = parent()->workingPath();
@@ -57,6 +60,8 @@ CMainWindow* CBuildEngine::parent()
 //------------------------------------------------------------------------------
 void CBuildEngine::processExit(int exitCode, QProcess::ExitStatus exitStatus)
 {
+  traceProcess();
+  parent()->uiScheduler()->flush();
   parent()->progressBar()->hide();
   
   if (exitStatus == QProcess::NormalExit && exitCode==0)
@@ -67,6 +72,9 @@ void CBuildEngine::processExit(int exitCode, QProcess::ExitStatus exitStatus)
 //------------------------------------------------------------------------------
 void CBuildEngine::processError(QProcess::ProcessError error)
 {
+  traceProcess();
+  // the log is displayed in the message box
+  parent()->uiScheduler()->flush();
   parent()->progressBar()->hide();
   
   QMessageBox msgBox;
@@ -80,7 +88,7 @@ void CBuildEngine::processError(QProcess::ProcessError error)
 //------------------------------------------------------------------------------
 void CBuildEngine::readProcessOut()
 {
-  parent()->log()->append(process()->readAllStandardOutput().data());
+  parent()->uiScheduler()->appendLog(process()->readAllStandardOutput().data());
 }
 //------------------------------------------------------------------------------
 void CBuildEngine::dialog()
@@ -115,9 +123,21 @@ void CBuildEngine::action()
   parent()->progressBar()->show();
   parent()->log()->clear();
   
+  m_traceStart = CTracer::isEnabled() ? CTracer::instance()->now() : -1;
   process()->start(processName(), processOptions());
 }
 //------------------------------------------------------------------------------
+void CBuildEngine::traceProcess()
+{
+  // the process runs across several turns of the event loop
+  if (m_traceStart < 0)
+    return;
+
+  CTracer *tracer = CTracer::instance();
+  tracer->record("CBuildEngine::process", m_traceStart, tracer->now() - m_traceStart);
+  m_traceStart = -1;
+}
+//------------------------------------------------------------------------------
 QString CBuildEngine::windowTitle() const
 {
   return m_windowTitle;
@@ -70,6 +70,8 @@ public:
   virtual QString workingPath() const;
     
 private:
+  void traceProcess();
+
   CMainWindow* m_parent;
   QProcess* m_process;
   QDialog* m_dialog;
@@ -81,6 +83,7 @@ private:
   QString m_statusSuccessMessage;
   QString m_statusErrorMessage;
   QStringList m_processOptions;
+  qint64 m_traceStart;
 
 };
 #endif // __BUILD_ENGINE_HH__
@@ -0,0 +1,293 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "cover-atlas.hh"
+
+#include <QDataStream>
+#include <QDir>
+#include <QPainter>
+
+#include <cstring>
+
+namespace
+{
+  const quint32 magic = 0x53424154; // "SBAT"
+  const quint32 version = 1;
+
+  const int KeySize = 20;                // sha1
+  const int RecordSize = KeySize + 2;    // key, width, height
+  const int SlotBytes = CCoverAtlas::SlotSize * CCoverAtlas::SlotSize * 4;
+  const int HeaderSize = 8;              // magic, version
+  const int InitialCapacity = 1024;
+}
+
+//------------------------------------------------------------------------------
+CCoverAtlas::CCoverAtlas(const QString & ADirectory)
+  : m_pixelFile(QString("%1/atlas-%2.pixels").arg(ADirectory).arg(int(SlotSize)))
+  , m_indexFile(QString("%1/atlas-%2.index").arg(ADirectory).arg(int(SlotSize)))
+  , m_buffer()
+  , m_pixels(0)
+  , m_capacity(0)
+  , m_image()
+  , m_slots()
+  , m_sizes()
+  , m_generation(0)
+  , m_mutex()
+{
+  QDir().mkpath(ADirectory);
+  load();
+}
+//------------------------------------------------------------------------------
+CCoverAtlas::~CCoverAtlas()
+{
+  if (m_pixels && m_buffer.isEmpty())
+    m_pixelFile.unmap(m_pixels);
+}
+//------------------------------------------------------------------------------
+void CCoverAtlas::load()
+{
+  // records are appended once the pixels of their slot are written,
+  // a partial record left by a crash is ignored
+  if (m_indexFile.open(QIODevice::ReadWrite))
+    {
+      QDataStream stream(&m_indexFile);
+      quint32 fileMagic = 0, fileVersion = 0;
+      stream >> fileMagic >> fileVersion;
+      bool valid = stream.status() == QDataStream::Ok
+	&& fileMagic == magic && fileVersion == version;
+
+      if (valid)
+	{
+	  QByteArray records = m_indexFile.readAll();
+	  int count = records.size() / RecordSize;
+	  qint64 pixels = m_pixelFile.exists() ? m_pixelFile.size() : 0;
+	  count = qMin<qint64>(count, pixels / SlotBytes);
+
+	  const char *record = records.constData();
+	  for (int slot = 0; slot < count; ++slot, record += RecordSize)
+	    {
+	      m_slots.insert(QByteArray(record, KeySize), slot);
+	      m_sizes.append(QSize(uchar(record[KeySize]), uchar(record[KeySize + 1])));
+	    }
+	  m_indexFile.resize(HeaderSize + qint64(count) * RecordSize);
+	}
+      else
+	{
+	  m_indexFile.resize(0);
+	  m_indexFile.seek(0);
+	  QDataStream header(&m_indexFile);
+	  header << magic << version;
+	  m_pixelFile.remove();
+	}
+      m_indexFile.seek(m_indexFile.size());
+    }
+
+  reserve(qMax(m_sizes.size(), InitialCapacity));
+}
+//------------------------------------------------------------------------------
+void CCoverAtlas::reserve(int count)
+{
+  if (count <= m_capacity)
+    return;
+
+  int capacity = qMax(count, 2 * m_capacity);
+  qint64 bytes = qint64(capacity) * SlotBytes;
+
+  if (m_buffer.isEmpty())
+    {
+      if (m_pixels)
+	{
+	  m_pixelFile.unmap(m_pixels);
+	  m_pixels = 0;
+	}
+      if (m_pixelFile.isOpen() || m_pixelFile.open(QIODevice::ReadWrite))
+	{
+	  if (m_pixelFile.size() < bytes)
+	    m_pixelFile.resize(bytes);
+	  m_pixels = m_pixelFile.map(0, bytes);
+	}
+    }
+
+  if (!m_pixels)
+    {
+      // keep the atlas in memory for this session
+      int size = m_buffer.size();
+      m_buffer.resize(bytes);
+      std::memset(m_buffer.data() + size, 0, bytes - size);
+      m_pixels = (uchar *) m_buffer.data();
+    }
+
+  m_capacity = capacity;
+  m_image = QImage(m_pixels, SlotSize, SlotSize * capacity,
+		   SlotSize * 4, QImage::Format_ARGB32_Premultiplied);
+}
+//------------------------------------------------------------------------------
+int CCoverAtlas::count() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_sizes.size();
+}
+//------------------------------------------------------------------------------
+int CCoverAtlas::generation() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_generation;
+}
+//------------------------------------------------------------------------------
+int CCoverAtlas::find(const QByteArray & key, int *generation) const
+{
+  QMutexLocker locker(&m_mutex);
+  if (generation)
+    *generation = m_generation;
+  return m_slots.value(key, -1);
+}
+//------------------------------------------------------------------------------
+int CCoverAtlas::insert(const QByteArray & key, const QImage & AImage,
+			int *generation)
+{
+  if (key.size() != KeySize || AImage.isNull())
+    return -1;
+
+  // scaled outside of the lock
+  QImage image = AImage;
+  if (image.width() > SlotSize || image.height() > SlotSize)
+    image = image.scaled(SlotSize, SlotSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+  QMutexLocker locker(&m_mutex);
+  if (generation)
+    *generation = m_generation;
+  QHash<QByteArray, int>::const_iterator it = m_slots.constFind(key);
+  if (it != m_slots.constEnd())
+    return it.value();
+
+  int slot = m_sizes.size();
+  reserve(slot + 1);
+
+  uchar *pixels = m_pixels + qint64(slot) * SlotBytes;
+  std::memset(pixels, 0, SlotBytes);
+  for (int y = 0; y < image.height(); ++y)
+    std::memcpy(pixels + y * SlotSize * 4, image.scanLine(y), image.width() * 4);
+
+  if (m_indexFile.isOpen())
+    {
+      writeRecord(key, image.size());
+      m_indexFile.flush();
+    }
+
+  m_slots.insert(key, slot);
+  m_sizes.append(image.size());
+  return slot;
+}
+//------------------------------------------------------------------------------
+void CCoverAtlas::writeRecord(const QByteArray & key, const QSize & size)
+{
+  char record[RecordSize];
+  std::memcpy(record, key.constData(), KeySize);
+  record[KeySize] = char(size.width());
+  record[KeySize + 1] = char(size.height());
+  m_indexFile.write(record, RecordSize);
+}
+//------------------------------------------------------------------------------
+QVector<int> CCoverAtlas::compact(const QSet<QByteArray> & keys, double ratio)
+{
+  QMutexLocker locker(&m_mutex);
+  int count = m_sizes.size();
+  QVector<QByteArray> slotKeys(count);
+  int live = 0;
+  for (QHash<QByteArray, int>::const_iterator it = m_slots.constBegin();
+       it != m_slots.constEnd(); ++it)
+    {
+      slotKeys[it.value()] = it.key();
+      if (keys.contains(it.key()))
+	++live;
+    }
+  if (count == 0 || live >= ratio * count)
+    return QVector<int>();
+
+  // the index is emptied first so that a crash while the pixels move
+  // leaves an empty atlas rather than keys on the pixels of others
+  if (m_indexFile.isOpen())
+    {
+      m_indexFile.resize(HeaderSize);
+      m_indexFile.seek(HeaderSize);
+    }
+
+  // the live slots only move down, in order
+  QVector<int> moved(count, -1);
+  QHash<QByteArray, int> liveSlots;
+  QVector<QSize> sizes;
+  for (int slot = 0; slot < count; ++slot)
+    {
+      if (!keys.contains(slotKeys[slot]))
+	continue;
+
+      int target = sizes.size();
+      if (target != slot)
+	std::memmove(m_pixels + qint64(target) * SlotBytes,
+		     m_pixels + qint64(slot) * SlotBytes, SlotBytes);
+      moved[slot] = target;
+      liveSlots.insert(slotKeys[slot], target);
+      sizes.append(m_sizes[slot]);
+      if (m_indexFile.isOpen())
+	writeRecord(slotKeys[slot], m_sizes[slot]);
+    }
+  if (m_indexFile.isOpen())
+    m_indexFile.flush();
+
+  m_slots = liveSlots;
+  m_sizes = sizes;
+  ++m_generation;
+
+  // the file shrinks back, the session buffer is kept
+  int capacity = qMax(m_sizes.size(), InitialCapacity);
+  if (m_buffer.isEmpty() && capacity < m_capacity)
+    {
+      m_pixelFile.unmap(m_pixels);
+      m_pixels = 0;
+      m_capacity = 0;
+      m_pixelFile.resize(qint64(capacity) * SlotBytes);
+      reserve(capacity);
+    }
+  return moved;
+}
+//------------------------------------------------------------------------------
+QRect CCoverAtlas::slotRect(int slot) const
+{
+  return QRect(QPoint(0, slot * SlotSize), m_sizes[slot]);
+}
+//------------------------------------------------------------------------------
+void CCoverAtlas::paint(QPainter *painter, const QRect & rect, int slot) const
+{
+  QMutexLocker locker(&m_mutex);
+  if (slot < 0 || slot >= m_sizes.size())
+    return;
+
+  QRect source = slotRect(slot);
+  QPoint position(rect.x() + (rect.width() - source.width()) / 2,
+		  rect.y() + (rect.height() - source.height()) / 2);
+  painter->drawImage(position, m_image, source);
+}
+//------------------------------------------------------------------------------
+QImage CCoverAtlas::image(int slot) const
+{
+  QMutexLocker locker(&m_mutex);
+  if (slot < 0 || slot >= m_sizes.size())
+    return QImage();
+
+  return m_image.copy(slotRect(slot));
+}
@@ -0,0 +1,107 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file cover-atlas.hh
+ *
+ * Atlas of the small cover thumbnails.
+ *
+ * All thumbnails are packed as fixed size slots into a single file
+ * mapped in memory, so that the view paints a cover by copying a
+ * rectangle of one image instead of going through a QPixmap per
+ * row. An index file next to it associates the cover keys, see
+ * CCoverCache::key(), to their slot and keeps the atlas across
+ * sessions. Slots are appended as covers are decoded and the atlas is
+ * compacted once most of them belong to covers no longer used.
+ *
+ */
+#ifndef __COVER_ATLAS_HH__
+#define __COVER_ATLAS_HH__
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+
+class QPainter;
+
+/** \class CCoverAtlas "cover-atlas.hh"
+ * \brief CCoverAtlas stores the small thumbnails in a memory mapped file
+ *
+ * Its methods may be called from any thread.
+ */
+class CCoverAtlas
+{
+public:
+  /// Slots are square, thumbnails are fitted into them.
+  enum { SlotSize = 24 };
+
+  CCoverAtlas(const QString & directory);
+  ~CCoverAtlas();
+
+  int count() const;
+
+  /// Number of compactions so far, the slots returned before the
+  /// last one are no longer valid.
+  int generation() const;
+
+  /// Returns the slot of the cover identified by \a key, or -1, and
+  /// the current generation in \a generation.
+  int find(const QByteArray & key, int *generation = 0) const;
+
+  /// Stores \a image for \a key and returns its slot, or -1, and the
+  /// current generation in \a generation.
+  int insert(const QByteArray & key, const QImage & image, int *generation = 0);
+
+  /// Drops the slots whose key is not in \a keys when they leave less
+  /// than \a ratio of the slots in use. Returns the new slot of each
+  /// previous slot, -1 if dropped, or an empty vector if the atlas is
+  /// kept as it is.
+  QVector<int> compact(const QSet<QByteArray> & keys, double ratio);
+
+  /// Paints \a slot centered in \a rect.
+  void paint(QPainter *painter, const QRect & rect, int slot) const;
+
+  /// Returns a copy of the thumbnail in \a slot.
+  QImage image(int slot) const;
+
+private:
+  void load();
+  void reserve(int count);
+  void writeRecord(const QByteArray & key, const QSize & size);
+  QRect slotRect(int slot) const;
+
+  QFile m_pixelFile;
+  QFile m_indexFile;
+  QByteArray m_buffer;   // used when the file cannot be mapped
+  uchar *m_pixels;
+  int m_capacity;
+
+  // thumbnails stacked vertically, shares the pixels
+  QImage m_image;
+
+  QHash<QByteArray, int> m_slots;
+  QVector<QSize> m_sizes;
+  int m_generation;
+  mutable QMutex m_mutex;
+};
+
+#endif // __COVER_ATLAS_HH__
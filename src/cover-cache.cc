@@ -0,0 +1,202 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "cover-cache.hh"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QStringList>
+#include <QThread>
+
+namespace
+{
+  const quint32 magic = 0x53425448; // "SBTH"
+  const quint32 version = 1;
+
+  const char *suffixes[] = { "24", "128" };
+}
+
+//------------------------------------------------------------------------------
+CCoverCache::CCoverCache(const QString & ADirectory)
+  : m_directory(ADirectory)
+{
+  if (m_directory.isEmpty())
+    m_directory = QString("%1/covers")
+      .arg(QDesktopServices::storageLocation(QDesktopServices::CacheLocation));
+  QDir().mkpath(m_directory);
+}
+//------------------------------------------------------------------------------
+CCoverCache::~CCoverCache()
+{}
+//------------------------------------------------------------------------------
+QString CCoverCache::directory() const
+{
+  return m_directory;
+}
+//------------------------------------------------------------------------------
+QSize CCoverCache::dimensions(Size size)
+{
+  switch (size)
+    {
+    case Small:
+      return QSize(24, 24);
+    case Preview:
+      return QSize(128, 128);
+    default:
+      break;
+    }
+  return QSize();
+}
+//------------------------------------------------------------------------------
+QImage CCoverCache::decode(const QString & cover, Size size)
+{
+  QImageReader reader(cover);
+  QSize original = reader.size();
+  if (original.isValid() && !original.isEmpty())
+    {
+      // same geometry as the covers previously scaled on display
+      QSize target = dimensions(size);
+      if (size == Small)
+	target.setHeight(qMax(1, original.height() * target.width() / original.width()));
+
+      // lets the jpeg decoder skip the discarded resolution
+      reader.setScaledSize(target);
+    }
+  return reader.read();
+}
+//------------------------------------------------------------------------------
+QByteArray CCoverCache::key(const QString & cover)
+{
+  QFileInfo info(cover);
+  if (!info.exists())
+    return QByteArray();
+
+  // covers shared by an album resolve to the same file
+  QByteArray key = QString("%1|%2|%3")
+    .arg(info.canonicalFilePath())
+    .arg(info.lastModified().toTime_t())
+    .arg(info.size()).toUtf8();
+  return QCryptographicHash::hash(key, QCryptographicHash::Sha1);
+}
+//------------------------------------------------------------------------------
+QString CCoverCache::fileName(const QString & cover, Size size) const
+{
+  return fileName(key(cover), size);
+}
+//------------------------------------------------------------------------------
+QString CCoverCache::fileName(const QByteArray & key, Size size) const
+{
+  if (key.isEmpty())
+    return QString();
+
+  return QString("%1/%2-%3.thumb").arg(m_directory)
+    .arg(QString(key.toHex())).arg(suffixes[size]);
+}
+//------------------------------------------------------------------------------
+QImage CCoverCache::thumbnail(const QString & cover, Size size) const
+{
+  QString file = fileName(cover, size);
+  if (file.isEmpty())
+    return QImage();
+
+  QImage image = read(file);
+  if (image.isNull())
+    {
+      image = decode(cover, size);
+      write(image, file);
+    }
+  return image;
+}
+//------------------------------------------------------------------------------
+void CCoverCache::prepare(const QString & cover) const
+{
+  // the key stats the cover, compute it once for all the sizes
+  QByteArray hash = key(cover);
+  if (hash.isEmpty())
+    return;
+
+  for (int size = 0; size < SizeCount; ++size)
+    {
+      QString file = fileName(hash, Size(size));
+      if (!QFile::exists(file))
+	write(decode(cover, Size(size)), file);
+    }
+}
+//------------------------------------------------------------------------------
+void CCoverCache::prune(const QSet<QByteArray> & AKeys) const
+{
+  QSet<QString> keys;
+  foreach (const QByteArray & key, AKeys)
+    keys.insert(QString(key.toHex()));
+
+  // the files are named after the keys, temporary files included
+  QDir directory(m_directory);
+  foreach (const QString & file,
+	   directory.entryList(QStringList() << "*.thumb*", QDir::Files))
+    if (!keys.contains(file.section('-', 0, 0)))
+      directory.remove(file);
+}
+//------------------------------------------------------------------------------
+QImage CCoverCache::read(const QString & file)
+{
+  QFile input(file);
+  if (!input.open(QIODevice::ReadOnly))
+    return QImage();
+
+  QDataStream stream(&input);
+  quint32 fileMagic, fileVersion, width, height;
+  stream >> fileMagic >> fileVersion >> width >> height;
+  if (stream.status() != QDataStream::Ok || fileMagic != magic
+      || fileVersion != version || width > 4096 || height > 4096)
+    return QImage();
+
+  // raw premultiplied pixels, read without decoding
+  QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+  int bytes = image.byteCount();
+  if (stream.readRawData((char *) image.bits(), bytes) != bytes)
+    return QImage();
+  return image;
+}
+//------------------------------------------------------------------------------
+bool CCoverCache::write(const QImage & AImage, const QString & file)
+{
+  if (AImage.isNull())
+    return false;
+
+  QImage image = AImage.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+  // write to a temporary file so that readers never see partial files
+  QString temporary = QString("%1.%2").arg(file).arg((quintptr) QThread::currentThreadId());
+  QFile output(temporary);
+  if (!output.open(QIODevice::WriteOnly))
+    return false;
+
+  QDataStream stream(&output);
+  stream << magic << version << quint32(image.width()) << quint32(image.height());
+  for (int y = 0; y < image.height(); ++y)
+    stream.writeRawData((const char *) image.scanLine(y), image.width() * 4);
+  output.close();
+
+  QFile::remove(file);
+  return QFile::rename(temporary, file);
+}
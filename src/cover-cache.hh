@@ -0,0 +1,85 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file cover-cache.hh
+ *
+ * Cache of cover thumbnails on disk.
+ *
+ * Thumbnails are stored uncompressed in the user cache directory,
+ * named after the canonical path and the modification time of the
+ * cover so that they are regenerated when the cover changes, and
+ * shared by the songs of an album.
+ *
+ */
+#ifndef __COVER_CACHE_HH__
+#define __COVER_CACHE_HH__
+
+#include <QByteArray>
+#include <QImage>
+#include <QSet>
+#include <QString>
+
+/** \class CCoverCache "cover-cache.hh"
+ * \brief CCoverCache provides the scaled covers displayed by the interface
+ *
+ * Its methods may be called from any thread.
+ */
+class CCoverCache
+{
+public:
+  enum Size
+    {
+      Small,    ///< cover column of the library, 24 pixels wide
+      Preview,  ///< cover of the current song, 128x128
+      SizeCount
+    };
+
+  CCoverCache(const QString & directory = QString());
+  ~CCoverCache();
+
+  QString directory() const;
+
+  /// Returns the thumbnail of \a cover, generating it if needed.
+  QImage thumbnail(const QString & cover, Size size) const;
+
+  /// Generates the missing thumbnails of \a cover.
+  void prepare(const QString & cover) const;
+
+  /// Removes the thumbnails whose key is not in \a keys, see key().
+  void prune(const QSet<QByteArray> & keys) const;
+
+  static QSize dimensions(Size size);
+
+  /// Identifies the content of \a cover, empty if it does not exist.
+  static QByteArray key(const QString & cover);
+
+  /// Decodes \a cover directly at the scale of \a size.
+  static QImage decode(const QString & cover, Size size);
+
+private:
+  QString fileName(const QString & cover, Size size) const;
+  QString fileName(const QByteArray & key, Size size) const;
+
+  static QImage read(const QString & file);
+  static bool write(const QImage & image, const QString & file);
+
+  QString m_directory;
+};
+
+#endif // __COVER_CACHE_HH__
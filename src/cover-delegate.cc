@@ -0,0 +1,63 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "cover-delegate.hh"
+
+#include <QApplication>
+#include <QIcon>
+#include <QPainter>
+
+#include "library.hh"
+#include "cover-atlas.hh"
+
+//------------------------------------------------------------------------------
+CCoverDelegate::CCoverDelegate(CLibrary *ALibrary, QObject *parent)
+  : QStyledItemDelegate(parent)
+  , m_library(ALibrary)
+  , m_missing(QIcon::fromTheme("image-missing").pixmap(CCoverAtlas::SlotSize,
+							CCoverAtlas::SlotSize))
+{}
+//------------------------------------------------------------------------------
+CCoverDelegate::~CCoverDelegate()
+{}
+//------------------------------------------------------------------------------
+void CCoverDelegate::paint(QPainter *painter, const QStyleOptionViewItem & option,
+			   const QModelIndex & index) const
+{
+  const QStyleOptionViewItemV3 *optionV3 =
+    qstyleoption_cast<const QStyleOptionViewItemV3 *>(&option);
+  const QWidget *widget = optionV3 ? optionV3->widget : 0;
+  QStyle *style = widget ? widget->style() : QApplication::style();
+  style->drawPrimitive(QStyle::PE_PanelItemViewItem, &option, painter, widget);
+
+  int slot = m_library->coverSlot(index.data(CLibrary::SongIdRole).toInt());
+  if (slot >= 0)
+    {
+      m_library->coverAtlas()->paint(painter, option.rect, slot);
+    }
+  else if (slot == CLibrary::CoverMissing)
+    {
+      painter->drawPixmap(option.rect.x() + (option.rect.width() - m_missing.width()) / 2,
+			  option.rect.y() + (option.rect.height() - m_missing.height()) / 2,
+			  m_missing);
+    }
+}
+//------------------------------------------------------------------------------
+QSize CCoverDelegate::sizeHint(const QStyleOptionViewItem &, const QModelIndex &) const
+{
+  return QSize(CCoverAtlas::SlotSize, CCoverAtlas::SlotSize);
+}
@@ -0,0 +1,56 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file cover-delegate.hh
+ *
+ * Delegate painting the covers of the library from the cover atlas.
+ *
+ */
+#ifndef __COVER_DELEGATE_HH__
+#define __COVER_DELEGATE_HH__
+
+#include <QStyledItemDelegate>
+#include <QPixmap>
+
+class CLibrary;
+
+/** \class CCoverDelegate "cover-delegate.hh"
+ * \brief CCoverDelegate paints a cover without querying the model for it
+ *
+ * Only the id of the song is read from the model, so that painting a
+ * row allocates neither a QVariant holding a QPixmap nor the pixmap
+ * itself.
+ */
+class CCoverDelegate : public QStyledItemDelegate
+{
+public:
+  CCoverDelegate(CLibrary *library, QObject *parent = 0);
+  ~CCoverDelegate();
+
+  void paint(QPainter *painter, const QStyleOptionViewItem & option,
+	     const QModelIndex & index) const;
+  QSize sizeHint(const QStyleOptionViewItem & option,
+		 const QModelIndex & index) const;
+
+private:
+  CLibrary *m_library;
+  QPixmap m_missing;
+};
+
+#endif // __COVER_DELEGATE_HH__
@@ -0,0 +1,188 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "cover-grid.hh"
+
+#include <QApplication>
+#include <QIcon>
+#include <QPainter>
+#include <QStyledItemDelegate>
+
+#include "library.hh"
+#include "thumbnail-loader.hh"
+
+namespace
+{
+  const int Margin = 4;
+
+  // paints a cell from the library, the model only gives the song id
+  class CoverGridDelegate : public QStyledItemDelegate
+  {
+  public:
+    CoverGridDelegate(CCoverGrid *grid)
+      : QStyledItemDelegate(grid)
+      , m_grid(grid)
+      , m_missing(QIcon::fromTheme("image-missing").pixmap(CCoverGrid::CoverSize,
+							     CCoverGrid::CoverSize))
+    {}
+
+    void paint(QPainter *painter, const QStyleOptionViewItem & option,
+	       const QModelIndex & index) const
+    {
+      const QStyleOptionViewItemV3 *optionV3 =
+	qstyleoption_cast<const QStyleOptionViewItemV3 *>(&option);
+      const QWidget *widget = optionV3 ? optionV3->widget : 0;
+      QStyle *style = widget ? widget->style() : QApplication::style();
+      style->drawPrimitive(QStyle::PE_PanelItemViewItem, &option, painter, widget);
+
+      int id = index.data(CLibrary::SongIdRole).toInt();
+      if (id < 0)
+	return;
+
+      const CSong & song = m_grid->library()->song(id);
+      const QRect & rect = option.rect;
+      QRect cover(rect.x() + (rect.width() - CCoverGrid::CoverSize) / 2,
+		  rect.y() + Margin, CCoverGrid::CoverSize, CCoverGrid::CoverSize);
+
+      if (!song.hasCover)
+	{
+	  painter->drawPixmap(cover.topLeft(), m_missing);
+	}
+      else if (const QPixmap *preview = m_grid->preview(song.coverPath))
+	{
+	  painter->drawPixmap(cover, *preview);
+	}
+      else
+	{
+	  painter->fillRect(cover, option.palette.midlight());
+	}
+
+      QRect text(rect.x() + Margin, cover.bottom() + Margin,
+		 rect.width() - 2 * Margin, rect.bottom() - cover.bottom() - Margin);
+      const QFontMetrics & metrics = option.fontMetrics;
+      painter->setPen(option.palette.color(option.state & QStyle::State_Selected ?
+					   QPalette::HighlightedText : QPalette::Text));
+      painter->drawText(text, Qt::AlignHCenter | Qt::AlignTop,
+			metrics.elidedText(song.title, Qt::ElideRight, text.width()));
+      text.setTop(text.top() + metrics.lineSpacing());
+      painter->drawText(text, Qt::AlignHCenter | Qt::AlignTop,
+			metrics.elidedText(song.artist, Qt::ElideRight, text.width()));
+    }
+
+    QSize sizeHint(const QStyleOptionViewItem &, const QModelIndex &) const
+    {
+      return QSize(CCoverGrid::CellWidth, CCoverGrid::CellHeight);
+    }
+
+  private:
+    CCoverGrid *m_grid;
+    QPixmap m_missing;
+  };
+
+  const int PreviewCacheSize = 256;
+}
+
+//------------------------------------------------------------------------------
+CCoverGrid::CCoverGrid(CLibrary *ALibrary, QWidget *parent)
+  : QListView(parent)
+  , m_library(ALibrary)
+  , m_previews(PreviewCacheSize)
+  , m_requested()
+{
+  // a wrapping list with uniform cells rather than the icon mode,
+  // which keeps a free position for every item
+  setViewMode(QListView::ListMode);
+  setFlow(QListView::LeftToRight);
+  setWrapping(true);
+  setMovement(QListView::Static);
+  setResizeMode(QListView::Adjust);
+  setUniformItemSizes(true);
+  setGridSize(QSize(CellWidth, CellHeight));
+  setSelectionMode(QAbstractItemView::MultiSelection);
+  // a cell stands for the whole row of its song in the table
+  setSelectionBehavior(QAbstractItemView::SelectRows);
+  setEditTriggers(QAbstractItemView::NoEditTriggers);
+  setItemDelegate(new CoverGridDelegate(this));
+
+  connect(m_library->thumbnails(), SIGNAL(previewReady(const QString &, const QImage &)),
+	  this, SLOT(showPreview(const QString &, const QImage &)));
+  connect(m_library->thumbnails(), SIGNAL(previewDropped(const QString &)),
+	  this, SLOT(dropPreview(const QString &)));
+}
+//------------------------------------------------------------------------------
+CCoverGrid::~CCoverGrid()
+{}
+//------------------------------------------------------------------------------
+CLibrary * CCoverGrid::library() const
+{
+  return m_library;
+}
+//------------------------------------------------------------------------------
+const QPixmap * CCoverGrid::preview(const QString & cover) const
+{
+  const QPixmap *pixmap = m_previews.object(cover);
+  if (!pixmap && !m_requested.contains(cover))
+    {
+      // painted last, decoded first
+      m_requested.insert(cover);
+      m_library->thumbnails()->requestPreview(cover);
+    }
+  return pixmap;
+}
+//------------------------------------------------------------------------------
+QSet<QString> CCoverGrid::visibleCovers() const
+{
+  QSet<QString> covers;
+  if (!isVisible() || !model())
+    return covers;
+
+  QModelIndex index = indexAt(QPoint(Margin, Margin));
+  if (!index.isValid())
+    return covers;
+
+  // keep the covers of the cells one page away from the viewport
+  int columns = qMax(1, viewport()->width() / CellWidth);
+  int page = columns * (viewport()->height() / CellHeight + 1);
+  int first = qMax(0, index.row() - page);
+  int last = qMin(model()->rowCount() - 1, index.row() + 2 * page);
+  for (int row = first; row <= last; ++row)
+    {
+      int id = model()->index(row, modelColumn()).data(CLibrary::SongIdRole).toInt();
+      if (id >= 0 && m_library->song(id).hasCover)
+	covers.insert(m_library->song(id).coverPath);
+    }
+  return covers;
+}
+//------------------------------------------------------------------------------
+void CCoverGrid::dropPreview(const QString & cover)
+{
+  // requested again if its cell is painted again
+  m_requested.remove(cover);
+}
+//------------------------------------------------------------------------------
+void CCoverGrid::showPreview(const QString & cover, const QImage & image)
+{
+  if (!m_requested.remove(cover))
+    return;
+
+  // a cover that cannot be decoded is not requested again
+  QPixmap *pixmap = new QPixmap(image.isNull() ?
+				QIcon::fromTheme("image-missing").pixmap(CoverSize, CoverSize) :
+				QPixmap::fromImage(image));
+  m_previews.insert(cover, pixmap);
+  viewport()->update();
+}
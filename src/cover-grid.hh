@@ -0,0 +1,72 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file cover-grid.hh
+ *
+ * Library view displaying the songs as a grid of covers.
+ *
+ */
+#ifndef __COVER_GRID_HH__
+#define __COVER_GRID_HH__
+
+#include <QListView>
+#include <QCache>
+#include <QPixmap>
+#include <QSet>
+
+class CLibrary;
+
+/** \class CCoverGrid "cover-grid.hh"
+ * \brief CCoverGrid displays the cover, artist and title of the songs
+ *
+ * The grid uses the proxy and selection models of the table view.
+ * Cells have a fixed size so that laying them out does not query the
+ * model, and only the visible ones are painted; their covers are
+ * decoded by the thumbnail loader and kept in a bounded cache.
+ */
+class CCoverGrid : public QListView
+{
+  Q_OBJECT
+
+public:
+  enum { CoverSize = 128, CellWidth = 160, CellHeight = 180 };
+
+  CCoverGrid(CLibrary *library, QWidget *parent = 0);
+  ~CCoverGrid();
+
+  CLibrary * library() const;
+
+  /// Returns the preview of \a cover, or 0 if it is being decoded.
+  const QPixmap * preview(const QString & cover) const;
+
+  /// Returns the covers of the cells on screen and around them, empty
+  /// if the grid is hidden.
+  QSet<QString> visibleCovers() const;
+
+private slots:
+  void showPreview(const QString & cover, const QImage & image);
+  void dropPreview(const QString & cover);
+
+private:
+  CLibrary *m_library;
+  mutable QCache<QString, QPixmap> m_previews;
+  mutable QSet<QString> m_requested;
+};
+
+#endif // __COVER_GRID_HH__
@@ -0,0 +1,149 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "debug-panel.hh"
+
+#include <QBoxLayout>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QTime>
+#include <QTimer>
+#include <QTreeWidget>
+
+#include "tracer.hh"
+
+namespace
+{
+  // older entries are dropped
+  const int MaximumStalls = 1000;
+
+  // delay between two refreshes of the metrics, in ms
+  const int MetricsInterval = 1000;
+
+  QString milliseconds(qint64 microseconds)
+  {
+    return QString::number(microseconds / 1000.0, 'f', 3);
+  }
+}
+
+//------------------------------------------------------------------------------
+CDebugPanel::CDebugPanel(QWidget *parent)
+  : QWidget(parent)
+  , m_tabs(new QTabWidget)
+  , m_stalls(new QTreeWidget)
+  , m_metrics(new QTreeWidget)
+  , m_refreshTimer(new QTimer(this))
+{
+  setWindowTitle(tr("Debug"));
+
+  m_stalls->setRootIsDecorated(false);
+  m_stalls->setUniformRowHeights(true);
+  m_stalls->setHeaderLabels(QStringList() << tr("Time") << tr("Operation")
+			    << tr("Duration (ms)"));
+  m_stalls->header()->setResizeMode(1, QHeaderView::Stretch);
+  m_stalls->header()->setStretchLastSection(false);
+  m_tabs->addTab(m_stalls, tr("Stalls"));
+
+  m_metrics->setRootIsDecorated(false);
+  m_metrics->setUniformRowHeights(true);
+  // durations are displayed in ms, counters as recorded
+  m_metrics->setHeaderLabels(QStringList() << tr("Name") << tr("Count")
+			     << tr("Total") << tr("Mean") << tr("Max")
+			     << tr("Last"));
+  m_metrics->header()->setResizeMode(0, QHeaderView::Stretch);
+  m_metrics->header()->setStretchLastSection(false);
+  m_tabs->addTab(m_metrics, tr("Metrics"));
+
+  // the metrics are only refreshed while visible
+  m_refreshTimer->setInterval(MetricsInterval);
+  connect(m_refreshTimer, SIGNAL(timeout()), SLOT(refreshMetrics()));
+  m_refreshTimer->start();
+
+  QDialogButtonBox *buttons = new QDialogButtonBox;
+  QPushButton *clearButton = buttons->addButton(tr("Clear"), QDialogButtonBox::ResetRole);
+  connect(clearButton, SIGNAL(clicked()), SLOT(clear()));
+
+  QBoxLayout *layout = new QVBoxLayout;
+  layout->addWidget(m_tabs);
+  layout->addWidget(buttons);
+  setLayout(layout);
+}
+//------------------------------------------------------------------------------
+CDebugPanel::~CDebugPanel()
+{}
+//------------------------------------------------------------------------------
+void CDebugPanel::addStall(const QString & operation, int duration)
+{
+  QTreeWidgetItem *item = new QTreeWidgetItem;
+  item->setText(0, QTime::currentTime().toString());
+  item->setText(1, operation);
+  item->setText(2, QString::number(duration));
+  item->setTextAlignment(2, Qt::AlignRight);
+  m_stalls->insertTopLevelItem(0, item);
+
+  if (m_stalls->topLevelItemCount() > MaximumStalls)
+    delete m_stalls->takeTopLevelItem(MaximumStalls);
+}
+//------------------------------------------------------------------------------
+void CDebugPanel::clear()
+{
+  m_stalls->clear();
+  CTracer::instance()->clear();
+  refreshMetrics();
+}
+//------------------------------------------------------------------------------
+void CDebugPanel::refreshMetrics()
+{
+  if (!m_metrics->isVisible())
+    return;
+
+  QList<CTracer::Metric> metrics = CTracer::instance()->metrics();
+  while (m_metrics->topLevelItemCount() > metrics.size())
+    delete m_metrics->takeTopLevelItem(m_metrics->topLevelItemCount() - 1);
+
+  for (int i = 0; i < metrics.size(); ++i)
+    {
+      const CTracer::Metric & metric = metrics[i];
+      QTreeWidgetItem *item = m_metrics->topLevelItem(i);
+      if (!item)
+	{
+	  item = new QTreeWidgetItem(m_metrics);
+	  for (int column = 1; column < 6; ++column)
+	    item->setTextAlignment(column, Qt::AlignRight);
+	}
+
+      item->setText(0, metric.name);
+      item->setText(1, QString::number(metric.count));
+      if (metric.counter)
+	{
+	  // counters have no duration
+	  item->setText(2, QString());
+	  item->setText(3, QString::number(metric.total / metric.count));
+	  item->setText(4, QString::number(metric.maximum));
+	  item->setText(5, QString::number(metric.last));
+	}
+      else
+	{
+	  item->setText(2, milliseconds(metric.total));
+	  item->setText(3, milliseconds(metric.total / metric.count));
+	  item->setText(4, milliseconds(metric.maximum));
+	  item->setText(5, milliseconds(metric.last));
+	}
+    }
+}
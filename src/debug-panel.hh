@@ -0,0 +1,60 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file debug-panel.hh
+ *
+ * Panel displaying the diagnostics gathered while the application
+ * runs: the stalls of the event loop and the metrics of the tracer.
+ *
+ */
+#ifndef __DEBUG_PANEL_HH__
+#define __DEBUG_PANEL_HH__
+
+#include <QWidget>
+
+class QTabWidget;
+class QTreeWidget;
+class QTimer;
+
+/** \class CDebugPanel "debug-panel.hh"
+ * \brief CDebugPanel lists the stalls of the event loop and the metrics
+ */
+class CDebugPanel : public QWidget
+{
+  Q_OBJECT
+
+public:
+  CDebugPanel(QWidget *parent = 0);
+  ~CDebugPanel();
+
+public slots:
+  void addStall(const QString & operation, int duration);
+  void clear();
+
+private slots:
+  void refreshMetrics();
+
+private:
+  QTabWidget *m_tabs;
+  QTreeWidget *m_stalls;
+  QTreeWidget *m_metrics;
+  QTimer *m_refreshTimer;
+};
+
+#endif // __DEBUG_PANEL_HH__
@@ -21,6 +21,7 @@
 #include "mainwindow.hh"
 #include "library.hh"
 #include "file-chooser.hh"
+#include "song-completer.hh"
 #include <QLayout>
 
 CDialogNewSong::CDialogNewSong(CMainWindow* AParent)
@@ -39,8 +40,12 @@ CDialogNewSong::CDialogNewSong(CMainWindow* AParent)
   connect(parent(), SIGNAL(workingPathChanged(QString)),
 	  this, SLOT(setWorkingPath(QString)));
 
+  CCompletionService *completion = parent()->library()->completion();
+  m_artistEdit->setCompleter(new CSongCompleter(completion, CCompletionService::Artists, m_artistEdit));
+
   //Optional fields
   QLineEdit* albumEdit = new QLineEdit;
+  albumEdit->setCompleter(new CSongCompleter(completion, CCompletionService::Albums, albumEdit));
 
   CFileChooser* coverEdit = new CFileChooser();
   coverEdit->setType(CFileChooser::OpenFileChooser);
@@ -0,0 +1,388 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "facet-panel.hh"
+
+#include <QHeaderView>
+#include <QMenu>
+#include <QTimer>
+
+#include "library.hh"
+#include "song-query.hh"
+
+namespace
+{
+  const char *facetTitles[] = {
+    QT_TRANSLATE_NOOP("CFacetPanel", "Artist"),
+    QT_TRANSLATE_NOOP("CFacetPanel", "Album"),
+    QT_TRANSLATE_NOOP("CFacetPanel", "Language"),
+    QT_TRANSLATE_NOOP("CFacetPanel", "Lilypond"),
+    QT_TRANSLATE_NOOP("CFacetPanel", "Cover")
+  };
+
+  const char *yes = QT_TRANSLATE_NOOP("CFacetPanel", "yes");
+  const char *no = QT_TRANSLATE_NOOP("CFacetPanel", "no");
+
+  const int FacetRole = Qt::UserRole;
+  const int ValueRole = Qt::UserRole + 1;
+}
+
+//------------------------------------------------------------------------------
+CFacetPanel::CFacetPanel(CLibrary *ALibrary, QWidget *parent)
+  : QTreeWidget(parent)
+  , m_library(ALibrary)
+  , m_dirty()
+  , m_updatePending(false)
+  , m_sortPending(false)
+  , m_result()
+  , m_filtered(false)
+{
+  setColumnCount(2);
+  setHeaderHidden(true);
+  setUniformRowHeights(true);
+  setContextMenuPolicy(Qt::CustomContextMenu);
+  header()->setStretchLastSection(false);
+  header()->setResizeMode(0, QHeaderView::Stretch);
+  header()->setResizeMode(1, QHeaderView::ResizeToContents);
+
+  for (int facet = 0; facet < FacetCount; ++facet)
+    {
+      QTreeWidgetItem *item = new QTreeWidgetItem(this);
+      item->setText(0, tr(facetTitles[facet]));
+      item->setFlags(Qt::ItemIsEnabled);
+      m_facets[facet].item = item;
+    }
+
+  connect(m_library, SIGNAL(songAdded(int)), this, SLOT(addSong(int)));
+  connect(m_library, SIGNAL(songRemoved(int)), this, SLOT(removeSong(int)));
+  connect(m_library, SIGNAL(songChanged(int)), this, SLOT(updateSong(int)));
+  connect(m_library, SIGNAL(songsCleared()), this, SLOT(reset()));
+
+  connect(this, SIGNAL(itemActivated(QTreeWidgetItem*, int)),
+	  this, SLOT(activate(QTreeWidgetItem*)));
+  connect(this, SIGNAL(customContextMenuRequested(const QPoint &)),
+	  this, SLOT(contextMenu(const QPoint &)));
+
+  reset();
+}
+//------------------------------------------------------------------------------
+CFacetPanel::~CFacetPanel()
+{}
+//------------------------------------------------------------------------------
+void CFacetPanel::reset()
+{
+  for (int facet = 0; facet < FacetCount; ++facet)
+    {
+      FacetData & data = m_facets[facet];
+      qDeleteAll(data.item->takeChildren());
+      data.ids.clear();
+      data.names.clear();
+      data.total.clear();
+      data.filtered.clear();
+      data.items.clear();
+      data.valueOfSong.clear();
+    }
+  m_dirty.clear();
+  m_result = CBitSet();
+  m_filtered = false;
+
+  const CBitSet & songs = m_library->songIds();
+  for (int id = songs.nextSetBit(0); id >= 0; id = songs.nextSetBit(id + 1))
+    addSong(id);
+}
+//------------------------------------------------------------------------------
+QString CFacetPanel::value(Facet facet, const CSong & song) const
+{
+  switch (facet)
+    {
+    case Artist:
+      return song.artist;
+    case Album:
+      return song.album;
+    case Language:
+      return song.lang;
+    case Lilypond:
+      return song.lilypond ? yes : no;
+    case Cover:
+      return song.hasCover ? yes : no;
+    default:
+      break;
+    }
+  return QString();
+}
+//------------------------------------------------------------------------------
+int CFacetPanel::valueId(Facet facet, const QString & value)
+{
+  if (value.isEmpty())
+    return -1;
+
+  FacetData & data = m_facets[facet];
+  QHash<QString, int>::const_iterator it = data.ids.constFind(value);
+  if (it != data.ids.constEnd())
+    return it.value();
+
+  int id = data.names.size();
+  QTreeWidgetItem *item = new QTreeWidgetItem(data.item);
+  item->setText(0, (facet == Lilypond || facet == Cover) ? tr(value.toLatin1().constData()) : value);
+  item->setData(0, FacetRole, facet);
+  item->setData(0, ValueRole, id);
+  item->setTextAlignment(1, Qt::AlignRight);
+
+  data.ids.insert(value, id);
+  data.names.append(value);
+  data.total.append(0);
+  data.filtered.append(0);
+  data.items.append(item);
+  m_sortPending = true;
+  return id;
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::addSong(int id)
+{
+  const CSong & song = m_library->song(id);
+
+  // while a filter is active, the new song is counted once the filter
+  // result including it is set
+  bool counted = !m_filtered;
+
+  for (int facet = 0; facet < FacetCount; ++facet)
+    {
+      FacetData & data = m_facets[facet];
+      int size = data.valueOfSong.size();
+      if (size <= id)
+	{
+	  data.valueOfSong.resize(id + 1);
+	  for (int i = size; i <= id; ++i)
+	    data.valueOfSong[i] = -1;
+	}
+
+      int v = valueId(Facet(facet), value(Facet(facet), song));
+      data.valueOfSong[id] = v;
+      if (v < 0)
+	continue;
+
+      ++data.total[v];
+      if (counted)
+	++data.filtered[v];
+      m_dirty.insert(qMakePair(facet, v));
+    }
+  scheduleUpdate();
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::removeSong(int id)
+{
+  bool counted = !m_filtered || m_result.testBit(id);
+  if (m_filtered && counted)
+    m_result.clearBit(id);
+
+  for (int facet = 0; facet < FacetCount; ++facet)
+    {
+      FacetData & data = m_facets[facet];
+      if (id >= data.valueOfSong.size())
+	continue;
+
+      int v = data.valueOfSong[id];
+      if (v < 0)
+	continue;
+
+      --data.total[v];
+      if (counted)
+	--data.filtered[v];
+      data.valueOfSong[id] = -1;
+      m_dirty.insert(qMakePair(facet, v));
+    }
+  scheduleUpdate();
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::updateSong(int id)
+{
+  const CSong & song = m_library->song(id);
+  bool counted = !m_filtered || m_result.testBit(id);
+
+  // the song moves to the values it has now, within the same filter
+  for (int facet = 0; facet < FacetCount; ++facet)
+    {
+      FacetData & data = m_facets[facet];
+      if (id >= data.valueOfSong.size())
+	continue;
+
+      int previous = data.valueOfSong[id];
+      int v = valueId(Facet(facet), value(Facet(facet), song));
+      if (v == previous)
+	continue;
+
+      if (previous >= 0)
+	{
+	  --data.total[previous];
+	  if (counted)
+	    --data.filtered[previous];
+	  m_dirty.insert(qMakePair(facet, previous));
+	}
+      data.valueOfSong[id] = v;
+      if (v >= 0)
+	{
+	  ++data.total[v];
+	  if (counted)
+	    ++data.filtered[v];
+	  m_dirty.insert(qMakePair(facet, v));
+	}
+    }
+  scheduleUpdate();
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::setResult(const CBitSet & result)
+{
+  // only the songs entering or leaving the result change the counts
+  CBitSet delta = (m_filtered ? m_result : m_library->songIds()) ^ result;
+  for (int id = delta.nextSetBit(0); id >= 0; id = delta.nextSetBit(id + 1))
+    {
+      int step = result.testBit(id) ? 1 : -1;
+      for (int facet = 0; facet < FacetCount; ++facet)
+	{
+	  FacetData & data = m_facets[facet];
+	  if (id >= data.valueOfSong.size())
+	    continue;
+
+	  int v = data.valueOfSong[id];
+	  if (v < 0)
+	    continue;
+
+	  data.filtered[v] += step;
+	  m_dirty.insert(qMakePair(facet, v));
+	}
+    }
+
+  m_result = result;
+  m_filtered = true;
+  updateItems();
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::clearResult()
+{
+  if (!m_filtered)
+    return;
+
+  setResult(m_library->songIds());
+  m_result = CBitSet();
+  m_filtered = false;
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::scheduleUpdate()
+{
+  if (m_updatePending)
+    return;
+
+  m_updatePending = true;
+  QTimer::singleShot(0, this, SLOT(updateItems()));
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::updateItems()
+{
+  m_updatePending = false;
+
+  QPair<int, int> pair;
+  foreach (pair, m_dirty)
+    {
+      FacetData & data = m_facets[pair.first];
+      QTreeWidgetItem *item = data.items[pair.second];
+      int count = data.filtered[pair.second];
+      item->setText(1, QString::number(count));
+      item->setHidden(count == 0 || data.total[pair.second] == 0);
+    }
+  m_dirty.clear();
+
+  if (m_sortPending)
+    {
+      for (int facet = 0; facet < FacetCount; ++facet)
+	m_facets[facet].item->sortChildren(0, Qt::AscendingOrder);
+      m_sortPending = false;
+    }
+}
+//------------------------------------------------------------------------------
+CBitSet CFacetPanel::songs(Facet facet, int value) const
+{
+  const QVector<int> & values = m_facets[facet].valueOfSong;
+  CBitSet songs(m_library->songIds().size());
+  for (int id = 0; id < values.size(); ++id)
+    if (values[id] == value)
+      songs.setBit(id);
+  return songs;
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::activate(QTreeWidgetItem *item)
+{
+  if (!item || !item->parent())
+    return;
+
+  Facet facet = Facet(item->data(0, FacetRole).toInt());
+  QString name = m_facets[facet].names[item->data(0, ValueRole).toInt()];
+
+  // the values are matched as a whole and not as a part of a longer one
+  switch (facet)
+    {
+    case Artist:
+      emit(filterRequested(QString("artist:=%1").arg(CSongQuery::quote(name))));
+      break;
+    case Album:
+      emit(filterRequested(QString("album:=%1").arg(CSongQuery::quote(name))));
+      break;
+    case Language:
+      emit(filterRequested(QString("lang:=%1").arg(CSongQuery::quote(name))));
+      break;
+    case Lilypond:
+      emit(filterRequested(QString("lilypond:%1").arg(name)));
+      break;
+    case Cover:
+      emit(filterRequested(QString("cover:%1").arg(name)));
+      break;
+    default:
+      break;
+    }
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::contextMenu(const QPoint & position)
+{
+  QTreeWidgetItem *item = itemAt(position);
+  if (!item || !item->parent())
+    return;
+
+  setCurrentItem(item);
+  QMenu menu;
+  menu.addAction(tr("Select songs"), this, SLOT(selectCurrent()));
+  menu.addAction(tr("Unselect songs"), this, SLOT(unselectCurrent()));
+  menu.exec(viewport()->mapToGlobal(position));
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::selectCurrent()
+{
+  updateSelection(true);
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::unselectCurrent()
+{
+  updateSelection(false);
+}
+//------------------------------------------------------------------------------
+void CFacetPanel::updateSelection(bool selection)
+{
+  QTreeWidgetItem *item = currentItem();
+  if (!item || !item->parent())
+    return;
+
+  Facet facet = Facet(item->data(0, FacetRole).toInt());
+  emit(selectionRequested(songs(facet, item->data(0, ValueRole).toInt()), selection));
+}
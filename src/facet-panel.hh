@@ -0,0 +1,106 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file facet-panel.hh
+ *
+ * Side panel for browsing the library by artist, album, language,
+ * lilypond and cover presence.
+ *
+ * Counts are never recomputed from the database: totals follow the
+ * songs added to and removed from the library and the counts of the
+ * current filter are updated from the difference between the previous
+ * and the new filter result.
+ *
+ */
+#ifndef __FACET_PANEL_HH__
+#define __FACET_PANEL_HH__
+
+#include <QTreeWidget>
+#include <QHash>
+#include <QVector>
+#include <QSet>
+
+#include "utils/bitset.hh"
+
+class CLibrary;
+struct CSong;
+
+/** \class CFacetPanel "facet-panel.hh"
+ * \brief CFacetPanel displays the values of the library with their counts
+ */
+class CFacetPanel : public QTreeWidget
+{
+  Q_OBJECT
+
+public:
+  enum Facet { Artist, Album, Language, Lilypond, Cover, FacetCount };
+
+  CFacetPanel(CLibrary *library, QWidget *parent = 0);
+  ~CFacetPanel();
+
+  /// Returns the ids of the songs having \a value for \a facet.
+  CBitSet songs(Facet facet, int value) const;
+
+public slots:
+  void setResult(const CBitSet & result);
+  void clearResult();
+
+signals:
+  void filterRequested(const QString & term);
+  void selectionRequested(const CBitSet & songs, bool selection);
+
+private slots:
+  void addSong(int id);
+  void removeSong(int id);
+  void updateSong(int id);
+  void reset();
+  void activate(QTreeWidgetItem *item);
+  void contextMenu(const QPoint & position);
+  void selectCurrent();
+  void unselectCurrent();
+  void updateItems();
+
+private:
+  struct FacetData
+  {
+    QTreeWidgetItem *item;
+    QHash<QString, int> ids;
+    QVector<QString> names;
+    QVector<int> total;
+    QVector<int> filtered;
+    QVector<QTreeWidgetItem*> items;
+    QVector<int> valueOfSong;
+  };
+
+  QString value(Facet facet, const CSong & song) const;
+  int valueId(Facet facet, const QString & value);
+  void scheduleUpdate();
+  void updateSelection(bool selection);
+
+  CLibrary *m_library;
+  FacetData m_facets[FacetCount];
+  QSet< QPair<int, int> > m_dirty;
+  bool m_updatePending;
+  bool m_sortPending;
+
+  CBitSet m_result;
+  bool m_filtered;
+};
+
+#endif // __FACET_PANEL_HH__
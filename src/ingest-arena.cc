@@ -0,0 +1,151 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "ingest-arena.hh"
+
+#include <QStringBuilder>
+#include <QTextCodec>
+
+#include <cstring>
+
+#include "library.hh"
+#include "tracer.hh"
+#include "utils/string-pool.hh"
+#include "utils/utils.hh"
+
+namespace
+{
+  // large enough for most song files, the buffer grows otherwise
+  const int InitialCapacity = 64 * 1024;
+
+  bool isAsciiCompatible(QTextCodec *codec)
+  {
+    // UTF-16 and UTF-32, detected from their byte order mark
+    int mib = codec->mibEnum();
+    return mib < 1013 || mib > 1019;
+  }
+}
+
+//------------------------------------------------------------------------------
+CIngestArena::CIngestArena(CStringPool *AStrings)
+  : m_strings(AStrings)
+  , m_file()
+  , m_buffer()
+  , m_localeCodec(QTextCodec::codecForLocale())
+  , m_codec(0)
+  , m_artistKey("by=")
+  , m_titleKey("beginsong{")
+  , m_albumKey(",album=")
+  , m_lilypondKey("\\lilypond")
+  , m_languageKey("selectlanguage{")
+  , m_coverKey(",cov=")
+{
+  m_buffer.reserve(InitialCapacity);
+}
+//------------------------------------------------------------------------------
+CIngestArena::~CIngestArena()
+{}
+//------------------------------------------------------------------------------
+bool CIngestArena::load(const QString & path)
+{
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::ReadOnly))
+    return false;
+
+  // the buffer keeps its capacity when resized
+  int size = int(m_file.size());
+  m_buffer.resize(size);
+  int length = size ? int(m_file.read(m_buffer.data(), size)) : 0;
+  m_file.close();
+  m_buffer.resize(qMax(0, length));
+
+  // as a text stream, carriage returns are dropped and the codec is
+  // the one of the locale unless there is a byte order mark
+  char *data = m_buffer.data();
+  char *end = data + m_buffer.size();
+  char *cr = static_cast<char*>(memchr(data, '\r', end - data));
+  if (cr)
+    {
+      char *out = cr;
+      for (char *in = cr; in < end; ++in)
+	if (*in != '\r')
+	  *out++ = *in;
+      m_buffer.resize(int(out - data));
+    }
+
+  m_codec = QTextCodec::codecForUtfText(m_buffer, m_localeCodec);
+  if (!isAsciiCompatible(m_codec))
+    {
+      // the keys are searched in ASCII
+      m_buffer = m_codec->toUnicode(m_buffer).toUtf8();
+      m_codec = QTextCodec::codecForName("UTF-8");
+    }
+  return true;
+}
+//------------------------------------------------------------------------------
+QString CIngestArena::capture(const CByteSearch & key, const char *stops) const
+{
+  // first non empty match of key([^stops]+)
+  const char *data = m_buffer.constData();
+  const int size = m_buffer.size();
+  const size_t stopCount = strlen(stops);
+  int from = 0;
+  for (;;)
+    {
+      int index = key.indexIn(data, size, from);
+      if (index < 0)
+	return QString();
+
+      int begin = index + key.pattern().size();
+      int end = begin;
+      while (end < size && !memchr(stops, data[end], stopCount))
+	++end;
+      if (end > begin)
+	return m_codec->toUnicode(data + begin, end - begin);
+      from = index + 1;
+    }
+}
+//------------------------------------------------------------------------------
+QString CIngestArena::intern(const QString & str) const
+{
+  return m_strings ? m_strings->intern(str) : str;
+}
+//------------------------------------------------------------------------------
+bool CIngestArena::read(const QString & path, CSong & song)
+{
+  {
+    SB_TRACE("ingest: read");
+    if (!load(path))
+      return false;
+  }
+
+  SB_TRACE("ingest: parse");
+  song.artist = intern(SbUtils::latexToUtf8(capture(m_artistKey, "[,|]")));
+  song.title = SbUtils::latexToUtf8(capture(m_titleKey, "[}"));
+  song.album = intern(SbUtils::latexToUtf8(capture(m_albumKey, "[]")));
+  song.lilypond = m_lilypondKey.indexIn(m_buffer.constData(), m_buffer.size()) >= 0;
+  song.lang = intern(capture(m_languageKey, "[}"));
+
+  // the cover is next to the song file
+  QString coverName = capture(m_coverKey, "[,");
+  int slash = path.lastIndexOf('/');
+  song.cover = path.leftRef(slash) % QLatin1Char('/') % coverName % QLatin1String(".jpg");
+  CLibrary::resolveCover(song);
+
+  song.path = path;
+  return true;
+}
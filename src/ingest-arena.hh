@@ -0,0 +1,76 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file ingest-arena.hh
+ *
+ * Reading of the song files during the ingest.
+ *
+ * An arena belongs to one worker and is reused for every song it
+ * reads: the file is loaded into a buffer that keeps its capacity and
+ * the fields of the header are found in the raw bytes, so that only
+ * the values kept by the song are allocated. The artist, album and
+ * language are interned in a table shared by the workers.
+ *
+ */
+#ifndef __INGEST_ARENA_HH__
+#define __INGEST_ARENA_HH__
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "utils/byte-search.hh"
+
+struct CSong;
+class CStringPool;
+class QTextCodec;
+
+/** \class CIngestArena "ingest-arena.hh"
+ * \brief CIngestArena holds the buffers of one ingest worker
+ */
+class CIngestArena
+{
+public:
+  CIngestArena(CStringPool *strings = 0);
+  ~CIngestArena();
+
+  /// Reads the song file \a path into \a song and resolves its cover,
+  /// the collation keys excepted. Returns false if unreadable.
+  bool read(const QString & path, CSong & song);
+
+private:
+  bool load(const QString & path);
+  QString capture(const CByteSearch & key, const char *stops) const;
+  QString intern(const QString & str) const;
+
+  CStringPool *m_strings;
+  QFile m_file;
+  QByteArray m_buffer;
+  QTextCodec *m_localeCodec;
+  QTextCodec *m_codec;
+
+  CByteSearch m_artistKey;
+  CByteSearch m_titleKey;
+  CByteSearch m_albumKey;
+  CByteSearch m_lilypondKey;
+  CByteSearch m_languageKey;
+  CByteSearch m_coverKey;
+};
+
+#endif // __INGEST_ARENA_HH__
@@ -21,17 +21,108 @@
 
 #include "library.hh"
 #include "mainwindow.hh"
+#include "song-query.hh"
+#include "song-completer.hh"
+#include "cover-cache.hh"
+#include "cover-atlas.hh"
+#include "thumbnail-loader.hh"
+#include "ui-update-scheduler.hh"
+#include "tracer.hh"
+#include "ingest-arena.hh"
+#include "song-writer.hh"
 #include "utils/utils.hh"
+#include "utils/parallel-sort.hh"
 using namespace SbUtils;
+
+namespace
+{
+  // share of the atlas slots used by the library below which the
+  // atlas is compacted
+  const double MinimumLiveSlots = 0.5;
+
+  // Artist then title order, the path separates homonyms
+  class SongLessThan
+  {
+  public:
+    SongLessThan(const QVector<CSong> & songs) : m_songs(songs.constData()) {}
+
+    bool operator()(int id1, int id2) const
+    {
+      const CSong & song1 = m_songs[id1];
+      const CSong & song2 = m_songs[id2];
+      int cmp = compareCollationKeys(song1.artistKey, song2.artistKey);
+      if (cmp == 0)
+	cmp = compareCollationKeys(song1.titleKey, song2.titleKey);
+      if (cmp == 0)
+	return song1.path < song2.path;
+      return cmp < 0;
+    }
+
+  private:
+    const CSong *m_songs;
+  };
+
+  const char * dataTraceName(int role)
+  {
+    switch (role)
+      {
+      case Qt::DisplayRole:
+	return "CLibrary::data(DisplayRole)";
+      case Qt::DecorationRole:
+	return "CLibrary::data(DecorationRole)";
+      case Qt::ToolTipRole:
+	return "CLibrary::data(ToolTipRole)";
+      case Qt::SizeHintRole:
+	return "CLibrary::data(SizeHintRole)";
+      case CLibrary::SongIdRole:
+	return "CLibrary::data(SongIdRole)";
+      default:
+	return "CLibrary::data(other roles)";
+      }
+  }
+}
 //------------------------------------------------------------------------------
 CLibrary::CLibrary(CMainWindow* AParent)
   : QSqlTableModel()
+  , m_songs()
+  , m_paths()
+  , m_songIds()
+  , m_liveSongs()
+  , m_languages()
+  , m_strings()
+  , m_completion(0)
+  , m_coverCache(new CCoverCache)
+  , m_coverAtlas(0)
+  , m_thumbnails(0)
+  , m_coverSongs()
+  , m_coverSlots()
+  , m_lilypondDecoration()
+  , m_missingCoverDecoration()
+  , m_pendingCoverDecoration()
+  , m_flagDecorations()
+  , m_coverDecorations(1024)
+  , m_sizeHints(true)
+  , m_rowIds()
+  , m_songRows()
+  , m_ranks()
+  , m_ranksValid(false)
 {
   m_parent = AParent;
   m_workingPath = parent()->workingPath();
   connect(parent(), SIGNAL(workingPathChanged(QString)),
 	  this, SLOT(setWorkingPath(QString)));
   
+  // connected first so that the cache is invalidated before the
+  // views are notified
+  connect(this, SIGNAL(modelReset()), SLOT(invalidateRows()));
+  connect(this, SIGNAL(layoutChanged()), SLOT(invalidateRows()));
+  connect(this, SIGNAL(rowsInserted(const QModelIndex &, int, int)),
+	  SLOT(cacheRowsInserted(const QModelIndex &, int, int)));
+  connect(this, SIGNAL(rowsRemoved(const QModelIndex &, int, int)),
+	  SLOT(cacheRowsRemoved(const QModelIndex &, int, int)));
+  connect(this, SIGNAL(dataChanged(const QModelIndex &, const QModelIndex &)),
+	  SLOT(cacheRowsChanged(const QModelIndex &, const QModelIndex &)));
+
   setTable("songs");
   setEditStrategy(QSqlTableModel::OnManualSubmit);
   select();
@@ -42,23 +133,32 @@ CLibrary::CLibrary(CMainWindow* AParent)
   setHeaderData(4, Qt::Horizontal, tr("Album"));
   setHeaderData(5, Qt::Horizontal, tr("Cover"));
   setHeaderData(6, Qt::Horizontal, tr("Language"));
+  setHeaderData(7, Qt::Horizontal, tr("Cover path"));
+  setHeaderData(8, Qt::Horizontal, tr("Has cover"));
 
   m_watcher = new QFileSystemWatcher;
   connect(m_watcher, SIGNAL(fileChanged(const QString &)),
 	  this, SLOT(updateSong(const QString &)));
+  connect(m_watcher, SIGNAL(directoryChanged(const QString &)),
+	  this, SLOT(updateCoverDirectory(const QString &)));
+
+  loadSongs();
+  m_completion = new CCompletionService(this);
 
-  m_pixmap = new QPixmap;
-  m_pixmap->load(":/icons/fr.png");
-  QPixmapCache::insert("french", *m_pixmap);
-  m_pixmap->load(":/icons/en.png");
-  QPixmapCache::insert("english", *m_pixmap);
-  m_pixmap->load(":/icons/es.png");
-  QPixmapCache::insert("spanish", *m_pixmap);
+  m_coverAtlas = new CCoverAtlas(m_coverCache->directory());
+  m_thumbnails = new CThumbnailLoader(m_coverCache, m_coverAtlas, this);
+  connect(m_thumbnails, SIGNAL(thumbnailReady(const QString &, int)),
+	  this, SLOT(updateCover(const QString &, int)));
+
+  loadDecorations();
 }
 //------------------------------------------------------------------------------
 CLibrary::~CLibrary()
 {
-  delete m_pixmap;
+  // waits for the threads using the cache
+  delete m_thumbnails;
+  delete m_coverAtlas;
+  delete m_coverCache;
 }
 //------------------------------------------------------------------------------
 CMainWindow* CLibrary::parent()
@@ -68,25 +168,44 @@ CMainWindow* CLibrary::parent()
 //------------------------------------------------------------------------------
 void CLibrary::retrieveSongs()
 {
+  SB_TRACE("CLibrary::retrieveSongs");
   //qDebug() << "CLibrary::retrieveSongs";
-  uint count = 0;
   QStringList filter = QStringList() << "*.sg";
   QString path = QString("%1/songs/").arg(workingPath());
   QStringList paths;
   if(!m_watcher->files().isEmpty())
     m_watcher->removePaths(m_watcher->files());
 
+  // insert all the new songs and submit them at once
+  QSqlDatabase db = QSqlDatabase::database();
+  db.transaction();
+  CIngestArena arena(&m_strings);
+  CSongWriter writer(db);
+
   QDirIterator it(path, filter, QDir::NoFilter, QDirIterator::Subdirectories);
   while(it.hasNext())
     {
-      parent()->statusBar()->showMessage(QString(tr("Inserting song : %1")).arg(it.fileInfo().fileName()));
+      parent()->uiScheduler()->setStatus(it.fileInfo().fileName());
       QString filePath = it.fileInfo().absoluteFilePath();
       if(!filePath.isEmpty())
 	paths << filePath;
-      parent()->progressBar()->setValue(++count);
-      addSong(it.next());
+      parent()->uiScheduler()->advance();
+      insertSong(it.next(), arena, writer);
     }
 
+  {
+    SB_TRACE("ingest: submit");
+    db.commit();
+    select();
+  }
+  SB_TRACE_COUNT("library songs", m_liveSongs.count());
+
+  {
+    // thumbnails of the covers no song refers to any more
+    SB_TRACE("ingest: prune thumbnails");
+    pruneCovers();
+  }
+
 #ifndef __APPLE__
   m_watcher->addPaths(paths);
 #endif
@@ -95,132 +214,621 @@ void CLibrary::retrieveSongs()
 }
 //------------------------------------------------------------------------------
 void CLibrary::addSong(const QString & path)
+{
+  CIngestArena arena(&m_strings);
+  CSongWriter writer;
+  if (insertSong(path, arena, writer))
+    select();
+}
+//------------------------------------------------------------------------------
+bool CLibrary::insertSong(const QString & path, CIngestArena & arena,
+			  CSongWriter & writer)
 {
   //do not insert if the song is already in the library
   if(containsSong(path))
-    return;
+    return false;
+
+  //qDebug() << "CLibrary::insertSong " << path;
+  CSong song;
+  if (!arena.read(path, song))
+    return false;
+
+  bool inserted;
+  {
+    SB_TRACE("ingest: insert");
+    inserted = writer.insert(song);
+  }
 
-  //qDebug() << "CLibrary::addSong " << path;
-  QFile file(path);
-  if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+  if(!inserted)
     {
-      QTextStream stream (&file);
-      QString fileStr = stream.readAll();
-      file.close();
-
-      QString artist;
-      QString title;
-      bool lilypond(false);
-      QString album;
-      QString coverName;
-      QString lang;
- 
-      //artist
-      QRegExp rx1("by=([^[,|\\]]+)");
-      rx1.indexIn(fileStr);
-      artist = latexToUtf8(rx1.cap(1));
-
-      //title
-      QRegExp rx2("beginsong\\{([^[\\}]+)");
-      rx2.indexIn(fileStr);
-      title = latexToUtf8(rx2.cap(1));
-
-      //album
-      QRegExp rx3(",album=([^[\\]]+)");
-      rx3.indexIn(fileStr);
-      album = latexToUtf8(rx3.cap(1));
-
-      //lilypond
-      QRegExp rx4("\\\\lilypond");
-      lilypond = QBool(rx4.indexIn(fileStr) > -1);
-
-      //lang
-      QRegExp rx5("selectlanguage\\{([^[\\}]+)");
-      rx5.indexIn(fileStr);
-      lang = rx5.cap(1);
-      
-      //cover
-      QRegExp rx6(",cov=([^[,]+)");
-      rx6.indexIn(fileStr);
-      coverName = rx6.cap(1);
-      QString coverPath = path;
-      //deletes "filename.sg" from string and keep the path
-      coverPath.replace( QRegExp("\\/([^\\/]*).sg"), QString() ); 
-
-      // Create the actual item
-      QSqlRecord song;
-      QSqlField f1("artist", QVariant::String);
-      QSqlField f2("title", QVariant::String);
-      QSqlField f3("lilypond", QVariant::Bool);
-      QSqlField f4("path", QVariant::String);
-      QSqlField f5("album", QVariant::String);
-      QSqlField f6("cover", QVariant::String);
-      QSqlField f7("lang", QVariant::String);
-   
-      f1.setValue(QVariant(artist));
-      f2.setValue(QVariant(title));
-      f3.setValue(QVariant(lilypond));
-      f4.setValue(QVariant(path));
-      f5.setValue(QVariant(album));
-      f6.setValue(QVariant(QString("%1/%2.jpg").arg(coverPath).arg(coverName)));
-      f7.setValue(QVariant(lang));
-      
-      song.append(f1);
-      song.append(f2);
-      song.append(f3);
-      song.append(f4);
-      song.append(f5);
-      song.append(f6);
-      song.append(f7);
-
-      if(!insertRecord(-1,song))
-	{
-	  qDebug() << "\n artiste = " << artist;
-	  qDebug() << "title = " << title;
-	  qDebug() << "lilypond = " << lilypond;
-	  qDebug() << "path = " << path;
-	  qDebug() << "album = " << album;
-	  qDebug() << "cover = " << QString("%1/%2.jpg").arg(coverPath).arg(coverName);
-	  qDebug() << "lang = " << lang;
-	  qWarning() << "CLibrary::addSongFromFile : unable to insert song " << path;
-	}
+      qDebug() << "\n artiste = " << song.artist;
+      qDebug() << "title = " << song.title;
+      qDebug() << "lilypond = " << song.lilypond;
+      qDebug() << "path = " << song.path;
+      qDebug() << "album = " << song.album;
+      qDebug() << "cover = " << song.cover;
+      qDebug() << "lang = " << song.lang;
+      qWarning() << "CLibrary::addSongFromFile : unable to insert song " << path
+		 << writer.lastError();
+      return false;
+    }
+
+  if (song.hasCover)
+    m_thumbnails->prepare(song.coverPath);
+  registerSong(song);
+  return true;
+}
+//------------------------------------------------------------------------------
+void CLibrary::createTables(QSqlDatabase & db)
+{
+  if (!db.tables().contains("songs"))
+    {
+      QSqlQuery query(db);
+      query.exec("create table songs ( artist text, "
+		 "title text, "
+		 "lilypond bool, "
+		 "path text, "
+		 "album text, "
+		 "cover text, "
+		 "lang text, "
+		 "cover_path text, "
+		 "has_cover bool)");
     }
-  submitAll();
+  else if (!db.record("songs").contains("has_cover"))
+    {
+      // the songs stored before are resolved when the library loads
+      QSqlQuery query(db);
+      query.exec("alter table songs add column cover_path text");
+      query.exec("alter table songs add column has_cover bool");
+    }
+
+  // indexes for the exact terms of the filter queries, which compare
+  // artists, albums and languages without case, see CSongQuery
+  QSqlQuery query(db);
+  query.exec("create index if not exists songs_path on songs (path)");
+  query.exec("create index if not exists songs_artist on songs (artist collate nocase)");
+  query.exec("create index if not exists songs_album on songs (album collate nocase)");
+  query.exec("drop index if exists songs_lang");
+  query.exec("create index if not exists songs_lang_nocase on songs (lang collate nocase)");
+  query.exec("create index if not exists songs_lilypond on songs (lilypond)");
 }
 //------------------------------------------------------------------------------
 void CLibrary::removeSong(const QString & path)
 {
   //qDebug() << "CLibrary::removeSong " << path;
-  QModelIndex index = createIndex(0,3); //column 3 stores the path
-  QModelIndexList list = match(index, Qt::DisplayRole, path, -1, Qt::MatchExactly);
-
-  foreach(index, list)
-    removeRows(index.row(), 1);
+  deleteSong(path);
+  select();
+}
+//------------------------------------------------------------------------------
+void CLibrary::deleteSong(const QString & path)
+{
+  // by path, the row of the song may not be fetched yet
+  QSqlQuery query;
+  query.prepare("DELETE FROM songs WHERE path = ?");
+  query.addBindValue(path);
+  query.exec();
+  unregisterSong(path);
+}
+//------------------------------------------------------------------------------
+void CLibrary::removeAllSongs()
+{
+  QSqlQuery query("delete from songs");
+  select();
 
-  submitAll();
+  m_songs.clear();
+  m_paths.clear();
+  m_songIds.clear();
+  m_liveSongs = CBitSet();
+  m_languages.clear();
+  m_strings.clear();
+  m_coverSongs.clear();
+  m_coverSlots.clear();
+  m_songRows.clear();
+  if (!m_coverDirectories.isEmpty())
+    m_watcher->removePaths(m_coverDirectories.keys());
+  m_coverDirectories.clear();
+  m_ranks.clear();
+  m_ranksValid = false;
+  emit(songsCleared());
 }
 //------------------------------------------------------------------------------
 void CLibrary::updateSong(const QString & path)
 {
   //qDebug() << "CLibrary::updateSong " << path;
-  removeSong(path);
+  deleteSong(path);
   addSong(path);
   emit(wasModified());
 }
 //------------------------------------------------------------------------------
 bool CLibrary::containsSong(const QString & path)
 {
-  //qDebug() << "CLibrary::containsSong " << path;
-  //QModelIndex index = createIndex(0,3); //column 3 stores the path
-  //QModelIndexList list = match(index, Qt::DisplayRole, path, -1, Qt::MatchExactly);
-  //return !list.isEmpty();
+  return m_songIds.contains(path);
+}
+//------------------------------------------------------------------------------
+void CLibrary::loadSongs()
+{
+  SB_TRACE("CLibrary::loadSongs");
   QSqlQuery query;
-  query.exec(QString("SELECT artist FROM songs WHERE path = '%1'").arg(path));
-  return query.next();
+  query.setForwardOnly(true);
+  query.exec("SELECT path, artist, title, album, lang, cover, lilypond, "
+	     "cover_path, has_cover FROM songs");
+  QList<int> unresolved;
+  while (query.next())
+    {
+      CSong song;
+      song.path = query.value(0).toString();
+      song.artist = m_strings.intern(query.value(1).toString());
+      song.title = query.value(2).toString();
+      song.album = m_strings.intern(query.value(3).toString());
+      song.lang = m_strings.intern(query.value(4).toString());
+      song.cover = query.value(5).toString();
+      song.lilypond = query.value(6).toBool();
+      bool unresolvedCover = query.value(8).isNull();
+      if (unresolvedCover)
+	{
+	  // songs stored before the cover columns existed
+	  resolveCover(song);
+	}
+      else
+	{
+	  song.coverPath = query.value(7).toString();
+	  song.hasCover = query.value(8).toBool();
+	}
+      int id = registerSong(song);
+      if (unresolvedCover)
+	unresolved << id;
+    }
+  query.finish();
+
+  // stored once so that the next sessions do not look for them again
+  if (!unresolved.isEmpty())
+    {
+      QSqlDatabase db = QSqlDatabase::database();
+      db.transaction();
+      QSqlQuery update;
+      update.prepare("UPDATE songs SET cover_path = ?, has_cover = ? WHERE path = ?");
+      foreach (int id, unresolved)
+	{
+	  const CSong & resolved = m_songs[id];
+	  update.addBindValue(resolved.coverPath);
+	  update.addBindValue(resolved.hasCover);
+	  update.addBindValue(resolved.path);
+	  update.exec();
+	}
+      db.commit();
+    }
+
+  // the rows were fetched before the songs were known
+  invalidateRows();
+}
+//------------------------------------------------------------------------------
+int CLibrary::registerSong(const CSong & song)
+{
+  int id = m_songs.size();
+  m_songs.append(song);
+  m_paths.append(song.path);
+  m_songs.last().artistKey = collationKey(song.artist);
+  m_songs.last().titleKey = collationKey(song.title);
+  m_ranksValid = false;
+  m_songIds.insert(song.path, id);
+  m_liveSongs.resize(id + 1);
+  m_liveSongs.setBit(id);
+  if (!song.lang.isEmpty())
+    {
+      CBitSet & language = m_languages[song.lang];
+      language.resize(id + 1);
+      language.setBit(id);
+    }
+  m_coverSlots.append(CoverMissing);
+  m_songRows.append(-1);
+  linkCover(id);
+  emit(songAdded(id));
+  return id;
+}
+//------------------------------------------------------------------------------
+void CLibrary::unregisterSong(const QString & path)
+{
+  int id = m_songIds.value(path, -1);
+  if (id < 0)
+    return;
+
+  m_songIds.remove(path);
+  m_liveSongs.clearBit(id);
+
+  QMap<QString, CBitSet>::iterator language = m_languages.find(m_songs[id].lang);
+  if (language != m_languages.end())
+    {
+      language->clearBit(id);
+      if (language->isEmpty())
+	m_languages.erase(language);
+    }
+
+  unlinkCover(id);
+  m_ranksValid = false;
+  emit(songRemoved(id));
+}
+//------------------------------------------------------------------------------
+void CLibrary::resolveCover(CSong & song)
+{
+  QFileInfo info(song.cover);
+  song.hasCover = info.exists();
+  song.coverPath = song.hasCover ? info.canonicalFilePath() : QString();
+}
+//------------------------------------------------------------------------------
+void CLibrary::linkCover(int id)
+{
+  linkCoverPath(id);
+
+  // a missing cover is watched as well so that it shows up once added
+  const CSong & song = m_songs[id];
+  if (song.cover.isEmpty())
+    return;
+
+  QString directory = QFileInfo(song.cover).absolutePath();
+  QList<int> & songs = m_coverDirectories[directory];
+#ifndef __APPLE__
+  if (songs.isEmpty())
+    m_watcher->addPath(directory);
+#endif
+  songs.append(id);
+}
+//------------------------------------------------------------------------------
+void CLibrary::unlinkCover(int id)
+{
+  unlinkCoverPath(id);
+
+  const CSong & song = m_songs[id];
+  if (song.cover.isEmpty())
+    return;
+
+  QHash<QString, QList<int> >::iterator directory =
+    m_coverDirectories.find(QFileInfo(song.cover).absolutePath());
+  if (directory != m_coverDirectories.end())
+    {
+      directory->removeOne(id);
+      if (directory->isEmpty())
+	{
+#ifndef __APPLE__
+	  m_watcher->removePath(directory.key());
+#endif
+	  m_coverDirectories.erase(directory);
+	}
+    }
+}
+//------------------------------------------------------------------------------
+void CLibrary::linkCoverPath(int id)
+{
+  const CSong & song = m_songs[id];
+  if (song.hasCover)
+    m_coverSongs[song.coverPath].append(id);
+  m_coverSlots[id] = song.hasCover ? CoverPending : CoverMissing;
+}
+//------------------------------------------------------------------------------
+void CLibrary::unlinkCoverPath(int id)
+{
+  QHash<QString, QList<int> >::iterator cover = m_coverSongs.find(m_songs[id].coverPath);
+  if (cover != m_coverSongs.end())
+    {
+      cover->removeOne(id);
+      if (cover->isEmpty())
+	m_coverSongs.erase(cover);
+    }
+}
+//------------------------------------------------------------------------------
+bool CLibrary::isCoverRewritten(int id, QHash<QString, bool> & rewritten) const
+{
+  // a pending cover gets the key of its current content when decoded
+  int slot = m_coverSlots[id];
+  if (slot == CoverPending)
+    return false;
+
+  const QString & coverPath = m_songs[id].coverPath;
+  QHash<QString, bool>::const_iterator it = rewritten.constFind(coverPath);
+  if (it != rewritten.constEnd())
+    return it.value();
+
+  bool changed = slot < 0 || m_coverAtlas->find(CCoverCache::key(coverPath)) != slot;
+  rewritten.insert(coverPath, changed);
+  return changed;
+}
+//------------------------------------------------------------------------------
+void CLibrary::updateCoverDirectory(const QString & directory)
+{
+  QList<int> songs = m_coverDirectories.value(directory);
+  if (songs.isEmpty())
+    return;
+
+  QSqlDatabase db = QSqlDatabase::database();
+  db.transaction();
+  QSqlQuery query;
+  query.prepare("UPDATE songs SET cover_path = ?, has_cover = ? WHERE path = ?");
+
+  // songs and covers share their directories, so most changes do not
+  // concern the covers: only the songs whose cover appeared,
+  // disappeared or was rewritten in place are updated
+  QHash<QString, bool> rewritten;
+  foreach (int id, songs)
+    {
+      CSong & song = m_songs[id];
+      CSong resolved;
+      resolved.cover = song.cover;
+      resolveCover(resolved);
+
+      bool moved = resolved.hasCover != song.hasCover || resolved.coverPath != song.coverPath;
+      if (!moved && !(song.hasCover && isCoverRewritten(id, rewritten)))
+	continue;
+
+      unlinkCoverPath(id);
+      song.hasCover = resolved.hasCover;
+      song.coverPath = resolved.coverPath;
+      linkCoverPath(id);
+
+      if (moved)
+	{
+	  query.addBindValue(song.coverPath);
+	  query.addBindValue(song.hasCover);
+	  query.addBindValue(song.path);
+	  query.exec();
+	}
+
+      if (song.hasCover)
+	m_thumbnails->prepare(song.coverPath);
+      if (moved)
+	emit(songChanged(id));
+
+      int row = songRow(id);
+      if (row >= 0)
+	emit(dataChanged(index(row, 5), index(row, 5)));
+    }
+  db.commit();
+}
+//------------------------------------------------------------------------------
+int CLibrary::songId(const QString & path) const
+{
+  return m_songIds.value(path, -1);
+}
+//------------------------------------------------------------------------------
+void CLibrary::mapRows(int first, int last)
+{
+  // the rows are mapped as soon as the model fetches them, so that
+  // both maps always cover every row of the model
+  for (int row = first; row <= last; ++row)
+    {
+      int id = songId(QSqlTableModel::data(index(row, 3), Qt::DisplayRole).toString());
+      m_rowIds[row] = id;
+      if (id >= 0 && id < m_songRows.size())
+	m_songRows[id] = row;
+    }
+}
+//------------------------------------------------------------------------------
+void CLibrary::moveRows(int first)
+{
+  for (int row = first; row < m_rowIds.size(); ++row)
+    {
+      int id = m_rowIds[row];
+      if (id >= 0 && id < m_songRows.size())
+	m_songRows[id] = row;
+    }
+}
+//------------------------------------------------------------------------------
+int CLibrary::songIdAt(int row) const
+{
+  if (row < 0 || row >= m_rowIds.size())
+    return -1;
+  return m_rowIds[row];
+}
+//------------------------------------------------------------------------------
+int CLibrary::songRow(int id) const
+{
+  if (id < 0 || id >= m_songRows.size())
+    return -1;
+  return m_songRows[id];
+}
+//------------------------------------------------------------------------------
+int CLibrary::songRow(const QString & path) const
+{
+  return songRow(songId(path));
+}
+//------------------------------------------------------------------------------
+void CLibrary::invalidateRows()
+{
+  m_rowIds.fill(-1, rowCount());
+  m_songRows.fill(-1, m_songs.size());
+  mapRows(0, m_rowIds.size() - 1);
+}
+//------------------------------------------------------------------------------
+void CLibrary::cacheRowsInserted(const QModelIndex & parent, int first, int last)
+{
+  Q_UNUSED(parent);
+  if (first > m_rowIds.size())
+    return;
+
+  // rows fetched or appended at the end do not move the others
+  m_rowIds.insert(first, last - first + 1, -1);
+  mapRows(first, last);
+  if (last + 1 < m_rowIds.size())
+    moveRows(last + 1);
+}
+//------------------------------------------------------------------------------
+void CLibrary::cacheRowsRemoved(const QModelIndex & parent, int first, int last)
+{
+  Q_UNUSED(parent);
+  if (first >= m_rowIds.size())
+    return;
+
+  last = qMin(last, m_rowIds.size() - 1);
+  for (int row = first; row <= last; ++row)
+    {
+      int id = m_rowIds[row];
+      if (id >= 0 && id < m_songRows.size())
+	m_songRows[id] = -1;
+    }
+  m_rowIds.remove(first, last - first + 1);
+  moveRows(first);
+}
+//------------------------------------------------------------------------------
+void CLibrary::cacheRowsChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight)
+{
+  // songs are identified by their path
+  if (topLeft.column() > 3 || bottomRight.column() < 3)
+    return;
+
+  int last = qMin(bottomRight.row(), m_rowIds.size() - 1);
+  for (int row = topLeft.row(); row <= last; ++row)
+    {
+      int id = m_rowIds[row];
+      if (id >= 0 && id < m_songRows.size() && m_songRows[id] == row)
+	m_songRows[id] = -1;
+    }
+  mapRows(topLeft.row(), last);
+}
+//------------------------------------------------------------------------------
+QVector<int> CLibrary::orderedSongIds(const CBitSet & songs) const
+{
+  QVector<int> ids;
+  ids.reserve(songs.count());
+  for (int id = songs.nextSetBit(0); id >= 0; id = songs.nextSetBit(id + 1))
+    if (m_liveSongs.testBit(id))
+      ids.append(id);
+
+  // place each id at its rank
+  const QVector<int> & ranks = songRanks();
+  QVector<int> ordered(m_liveSongs.count(), -1);
+  foreach (int id, ids)
+    ordered[ranks[id]] = id;
+
+  int size = 0;
+  for (int i = 0; i < ordered.size(); ++i)
+    if (ordered[i] >= 0)
+      ordered[size++] = ordered[i];
+  ordered.resize(size);
+  return ordered;
+}
+//------------------------------------------------------------------------------
+QStringList CLibrary::paths(const CBitSet & songs) const
+{
+  QVector<int> ids = orderedSongIds(songs);
+  const QString *paths = m_paths.constData();
+
+  QStringList result;
+  result.reserve(ids.size());
+  foreach (int id, ids)
+    result << paths[id];
+  return result;
+}
+//------------------------------------------------------------------------------
+QStringList CLibrary::languages() const
+{
+  return m_languages.keys();
+}
+//------------------------------------------------------------------------------
+CBitSet CLibrary::languageSongs(const QString & language) const
+{
+  return m_languages.value(language);
+}
+//------------------------------------------------------------------------------
+const QVector<int> & CLibrary::songRanks() const
+{
+  if (m_ranksValid)
+    return m_ranks;
+
+  SB_TRACE("CLibrary::songRanks");
+  QVector<int> ids;
+  ids.reserve(m_liveSongs.count());
+  for (int id = m_liveSongs.nextSetBit(0); id >= 0; id = m_liveSongs.nextSetBit(id + 1))
+    ids.append(id);
+
+  sortSongs(m_songs, ids);
+
+  // removed songs are ranked last
+  m_ranks.fill(ids.size(), m_songs.size());
+  for (int rank = 0; rank < ids.size(); ++rank)
+    m_ranks[ids[rank]] = rank;
+  m_ranksValid = true;
+  return m_ranks;
+}
+//------------------------------------------------------------------------------
+void CLibrary::sortSongs(const QVector<CSong> & songs, QVector<int> & ids)
+{
+  parallelSort(ids.begin(), ids.end(), SongLessThan(songs));
+}
+//------------------------------------------------------------------------------
+const CSong & CLibrary::song(int id) const
+{
+  return m_songs.at(id);
+}
+//------------------------------------------------------------------------------
+const CBitSet & CLibrary::songIds() const
+{
+  return m_liveSongs;
+}
+//------------------------------------------------------------------------------
+CBitSet CLibrary::search(const CSongQuery & query) const
+{
+  SB_TRACE("CLibrary::search");
+  CBitSet songs(m_songs.size());
+  QVariantList bindings;
+  QSqlQuery sqlQuery;
+  sqlQuery.setForwardOnly(true);
+  sqlQuery.prepare(QString("SELECT path FROM songs WHERE %1").arg(query.toSql(bindings)));
+  foreach (const QVariant & value, bindings)
+    sqlQuery.addBindValue(value);
+
+  if (!sqlQuery.exec())
+    {
+      qWarning() << "CLibrary::search : unable to run query " << query.text()
+		 << sqlQuery.lastError().text();
+      return songs;
+    }
+
+  while (sqlQuery.next())
+    {
+      int id = songId(sqlQuery.value(0).toString());
+      if (id >= 0)
+	songs.setBit(id);
+    }
+
+  return songs;
+}
+//------------------------------------------------------------------------------
+CLibrary::CDecoration CLibrary::decoration(const QPixmap & pixmap) const
+{
+  CDecoration decoration;
+  decoration.pixmap = pixmap;
+  if (!pixmap.isNull())
+    decoration.size = pixmap.size();
+  return decoration;
+}
+//------------------------------------------------------------------------------
+void CLibrary::loadDecorations()
+{
+  m_lilypondDecoration = decoration(QIcon::fromTheme("audio-x-generic").pixmap(24,24));
+  m_missingCoverDecoration = decoration(QIcon::fromTheme("image-missing").pixmap(24,24));
+
+  QPixmap placeholder(24, 24);
+  placeholder.fill(Qt::transparent);
+  m_pendingCoverDecoration = decoration(placeholder);
+
+  m_flagDecorations.insert("french", decoration(QPixmap(":/icons/fr.png")));
+  m_flagDecorations.insert("english", decoration(QPixmap(":/icons/en.png")));
+  m_flagDecorations.insert("spanish", decoration(QPixmap(":/icons/es.png")));
+}
+//------------------------------------------------------------------------------
+QPixmap CLibrary::languageFlag(const QString & language) const
+{
+  return m_flagDecorations.value(language).pixmap.value<QPixmap>();
 }
 //------------------------------------------------------------------------------
 QVariant CLibrary::data(const QModelIndex &index, int role) const
 {
+  CTraceScope trace(CTracer::isEnabled() ? dataTraceName(role) : 0);
+
+  if (role == SongIdRole)
+    return songIdAt(index.row());
+
+  if (role == Qt::SizeHintRole && !m_sizeHints)
+    return QVariant();
+
   //Draws lilypondcheck
   if ( index.column() == 2 )
     {
@@ -229,15 +837,14 @@ QVariant CLibrary::data(const QModelIndex &index, int role) const
 
       if(QSqlTableModel::data( index, Qt::DisplayRole ).toBool())
 	{
-	  *m_pixmap = QPixmap(QIcon::fromTheme("audio-x-generic").pixmap(24,24));
 	  if ( role == Qt::DecorationRole )
-	    return *m_pixmap;
+	    return m_lilypondDecoration.pixmap;
 	  
-	  if( m_pixmap->isNull() )
+	  if( m_lilypondDecoration.size.isNull() )
 	    return true;
 
 	  if ( role == Qt::SizeHintRole )
-	    return m_pixmap->size();
+	    return m_lilypondDecoration.size;
 	}
       return QString();
     }
@@ -245,22 +852,33 @@ QVariant CLibrary::data(const QModelIndex &index, int role) const
   //Draws the cover
   if ( index.column() == 5 )
     {
-      QString imgFile = QSqlTableModel::data( index, Qt::DisplayRole ).toString();
       if ( Qt::DisplayRole == role )
 	return QString();
 
-      *m_pixmap = QIcon::fromTheme("image-missing").pixmap(24,24);;
-      if (!imgFile.isEmpty() && QFile::exists( imgFile ) && !QPixmapCache::find(imgFile, m_pixmap))
+      if ( role != Qt::DecorationRole && role != Qt::SizeHintRole )
+	return QSqlTableModel::data( index, role );
+
+      // the views paint the covers from the atlas, see CCoverDelegate
+      int slot = coverSlot(songIdAt(index.row()));
+      if (slot >= 0)
 	{
-	  *m_pixmap = QPixmap::fromImage(QImage(imgFile).scaledToWidth(24));
-	  QPixmapCache::insert(imgFile, *m_pixmap);
+	  if ( role != Qt::DecorationRole )
+	    return QSize(CCoverAtlas::SlotSize, CCoverAtlas::SlotSize);
+
+	  QVariant *cover = m_coverDecorations.object(slot);
+	  if (!cover)
+	    {
+	      cover = new QVariant(QPixmap::fromImage(m_coverAtlas->image(slot)));
+	      m_coverDecorations.insert(slot, cover);
+	    }
+	  return *cover;
 	}
 
+      const CDecoration & cover = (slot == CoverPending) ?
+	m_pendingCoverDecoration : m_missingCoverDecoration;
       if ( role == Qt::DecorationRole )
-	return *m_pixmap;
-
-      if ( role == Qt::SizeHintRole )
-	return m_pixmap->size();
+	return cover.pixmap;
+      return cover.size;
     }
 
   //Draws language flag
@@ -274,13 +892,14 @@ QVariant CLibrary::data(const QModelIndex &index, int role) const
       if ( role == Qt::ToolTipRole )
       	return lang;
 
-      if(QPixmapCache::find(lang, m_pixmap))
+      QHash<QString, CDecoration>::const_iterator flag = m_flagDecorations.constFind(lang);
+      if (flag != m_flagDecorations.constEnd())
 	{
 	  if ( role == Qt::DecorationRole )
-	    return *m_pixmap;
+	    return flag->pixmap;
 
 	  if ( role == Qt::SizeHintRole )
-	    return m_pixmap->size();
+	    return flag->size;
 	}
     }
   return QSqlTableModel::data( index, role );
@@ -296,3 +915,83 @@ void CLibrary::setWorkingPath(QString value)
   m_workingPath = value;
 }
 //------------------------------------------------------------------------------
+bool CLibrary::sizeHintsEnabled() const
+{
+  return m_sizeHints;
+}
+//------------------------------------------------------------------------------
+void CLibrary::setSizeHintsEnabled(bool value)
+{
+  m_sizeHints = value;
+}
+//------------------------------------------------------------------------------
+CCompletionService * CLibrary::completion() const
+{
+  return m_completion;
+}
+//------------------------------------------------------------------------------
+CCoverCache * CLibrary::coverCache() const
+{
+  return m_coverCache;
+}
+//------------------------------------------------------------------------------
+CCoverAtlas * CLibrary::coverAtlas() const
+{
+  return m_coverAtlas;
+}
+//------------------------------------------------------------------------------
+CThumbnailLoader * CLibrary::thumbnails() const
+{
+  return m_thumbnails;
+}
+//------------------------------------------------------------------------------
+int CLibrary::coverSlot(int id) const
+{
+  if (id < 0 || id >= m_coverSlots.size())
+    return CoverMissing;
+
+  int slot = m_coverSlots[id];
+  if (slot == CoverPending)
+    m_thumbnails->request(m_songs[id].coverPath);
+  return slot;
+}
+//------------------------------------------------------------------------------
+void CLibrary::pruneCovers()
+{
+  QSet<QByteArray> keys;
+  foreach (const QString & cover, m_coverSongs.keys())
+    {
+      QByteArray key = CCoverCache::key(cover);
+      if (!key.isEmpty())
+	keys.insert(key);
+    }
+  m_coverCache->prune(keys);
+
+  QVector<int> moved = m_coverAtlas->compact(keys, MinimumLiveSlots);
+  if (moved.isEmpty())
+    return;
+
+  // the songs whose cover lost its slot request it again
+  m_coverDecorations.clear();
+  for (int id = 0; id < m_coverSlots.size(); ++id)
+    {
+      int slot = m_coverSlots[id];
+      if (slot >= 0)
+	m_coverSlots[id] = moved.value(slot, -1) >= 0 ? moved[slot] : int(CoverPending);
+    }
+  if (rowCount() > 0)
+    emit(dataChanged(index(0, 5), index(rowCount() - 1, 5)));
+}
+//------------------------------------------------------------------------------
+void CLibrary::updateCover(const QString & cover, int slot)
+{
+  // a cover that cannot be decoded is not requested again
+  foreach (int id, m_coverSongs.value(cover))
+    {
+      m_coverSlots[id] = slot >= 0 ? slot : int(CoverMissing);
+      int row = songRow(id);
+      if (row >= 0)
+	emit(dataChanged(index(row, 5), index(row, 5)));
+    }
+}
+//------------------------------------------------------------------------------
@@ -26,16 +26,63 @@
 #define __LIBRARY_HH__
 
 #include <QString>
+#include <QStringList>
+#include <QCache>
+#include <QHash>
+#include <QMap>
+#include <QVector>
 #include <QSqlTableModel>
+#include <QSqlRecord>
+#include <QSqlDatabase>
+#include <QPixmap>
+
+#include "utils/bitset.hh"
+#include "utils/string-pool.hh"
 
 class CMainWindow;
+class CSongQuery;
+class CCompletionService;
+class CCoverCache;
+class CCoverAtlas;
+class CThumbnailLoader;
+class CIngestArena;
+class CSongWriter;
 class QFileSystemWatcher;
 
+/** \struct CSong "library.hh"
+ * \brief CSong is the in-memory description of a song of the library
+ */
+struct CSong
+{
+  QString path;
+  QString artist;
+  QString title;
+  QString album;
+  QString lang;
+  QString cover;
+  bool lilypond;
+
+  // resolved when the song is added and when the directory of the
+  // cover changes, the cover path is canonical and empty if missing
+  bool hasCover;
+  QString coverPath;
+
+  // collation keys of the artist and title, see SbUtils::collationKey()
+  QByteArray artistKey;
+  QByteArray titleKey;
+};
+
 class CLibrary : public QSqlTableModel
 {
   Q_OBJECT
 
 public:
+  /// Role returning the id of the song of a row.
+  enum { SongIdRole = Qt::UserRole + 1 };
+
+  /// Values returned by coverSlot() when the cover is not in the atlas.
+  enum { CoverPending = -1, CoverMissing = -2 };
+
   CLibrary(CMainWindow* parent=NULL);
   ~CLibrary();
 
@@ -44,22 +91,141 @@ public:
   void addSong(const QString & path);
   void removeSong(const QString & path);
   bool containsSong(const QString & path);
+  CBitSet search(const CSongQuery & query) const;
   QVariant data(const QModelIndex &index, int role) const;
   CMainWindow* parent();
+
+  // Songs are identified by an id which remains valid for the whole
+  // session. Ids of removed songs are not reused.
+  int songId(const QString & path) const;
+  int songIdAt(int row) const;
+  /// Row of the song in the model, or -1 if not fetched yet.
+  int songRow(int id) const;
+  int songRow(const QString & path) const;
+  const CSong & song(int id) const;
+  const CBitSet & songIds() const;
+
+  /// Ids of \a songs in artist then title order.
+  QVector<int> orderedSongIds(const CBitSet & songs) const;
+  /// Paths of \a songs in artist then title order.
+  QStringList paths(const CBitSet & songs) const;
+
+  /// Languages of the songs, as found in the song files.
+  QStringList languages() const;
+  /// Ids of the songs in \a language.
+  CBitSet languageSongs(const QString & language) const;
+  /// Flag of \a language, null if there is none.
+  QPixmap languageFlag(const QString & language) const;
+
+  /// Position of each song id in the artist then title order.
+  const QVector<int> & songRanks() const;
+
+  /// Whether data() answers Qt::SizeHintRole, so that the views can
+  /// assume uniform cells on large libraries.
+  bool sizeHintsEnabled() const;
+  void setSizeHintsEnabled(bool value);
+
+  CCompletionService * completion() const;
+  CCoverCache * coverCache() const;
+  CCoverAtlas * coverAtlas() const;
+  CThumbnailLoader * thumbnails() const;
+
+  /// Slot of the cover of song \a id in the atlas. A pending cover is
+  /// queued for loading and the row updated once it is stored.
+  int coverSlot(int id) const;
+
+  // building blocks of the ingest, also used by the benchmarks, the
+  // song files are read with CIngestArena and stored with CSongWriter
+
+  /// Resolves the canonical path of the cover of \a song.
+  static void resolveCover(CSong & song);
+  /// Creates or upgrades the songs table and its indexes.
+  static void createTables(QSqlDatabase & db);
+  /// Sorts \a ids in artist then title order of \a songs.
+  static void sortSongs(const QVector<CSong> & songs, QVector<int> & ids);
   
 public slots:
   void setWorkingPath(QString);
   void retrieveSongs();
   void updateSong(const QString & path);
+  void removeAllSongs();
 
 signals:
   void wasModified();
+  void songAdded(int id);
+  void songRemoved(int id);
+  /// Emitted when the cover of song \a id appeared or disappeared.
+  void songChanged(int id);
+  void songsCleared();
+
+private slots:
+  void invalidateRows();
+  void cacheRowsInserted(const QModelIndex & parent, int first, int last);
+  void cacheRowsRemoved(const QModelIndex & parent, int first, int last);
+  void cacheRowsChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight);
+  void updateCover(const QString & cover, int slot);
+  void updateCoverDirectory(const QString & directory);
 
 private:
+  bool insertSong(const QString & path, CIngestArena & arena, CSongWriter & writer);
+  void loadSongs();
+  int registerSong(const CSong & song);
+  void unregisterSong(const QString & path);
+  void deleteSong(const QString & path);
+  void mapRows(int first, int last);
+  void moveRows(int first);
+  void loadDecorations();
+  void linkCover(int id);
+  void unlinkCover(int id);
+  void linkCoverPath(int id);
+  void unlinkCoverPath(int id);
+  bool isCoverRewritten(int id, QHash<QString, bool> & rewritten) const;
+  void pruneCovers();
+
   CMainWindow* m_parent;
-  QPixmap* m_pixmap;
   QString m_workingPath;
   QFileSystemWatcher* m_watcher;
+
+  QVector<CSong> m_songs;
+  QVector<QString> m_paths;
+  QHash<QString, int> m_songIds;
+  CBitSet m_liveSongs;
+  QMap<QString, CBitSet> m_languages;
+  // artists, albums and languages of the songs
+  CStringPool m_strings;
+  CCompletionService *m_completion;
+  CCoverCache *m_coverCache;
+  CCoverAtlas *m_coverAtlas;
+  CThumbnailLoader *m_thumbnails;
+  QHash<QString, QList<int> > m_coverSongs;
+  QVector<int> m_coverSlots;
+  QHash<QString, QList<int> > m_coverDirectories;
+
+  // decorations built once, copying a QVariant only shares its data
+  struct CDecoration
+  {
+    QVariant pixmap;
+    QVariant size;
+  };
+  CDecoration decoration(const QPixmap & pixmap) const;
+
+  CDecoration m_lilypondDecoration;
+  CDecoration m_missingCoverDecoration;
+  CDecoration m_pendingCoverDecoration;
+  QHash<QString, CDecoration> m_flagDecorations;
+  // decorations of the atlas slots painted last, the thumbnail of a
+  // slot only changes when the atlas is compacted
+  mutable QCache<int, QVariant> m_coverDecorations;
+  bool m_sizeHints;
+
+  // song id of each fetched row and row of each song id, -1 if none,
+  // updated as the model resets, fetches, inserts and removes rows
+  QVector<int> m_rowIds;
+  QVector<int> m_songRows;
+
+  // caches rebuilt on demand
+  mutable QVector<int> m_ranks;
+  mutable bool m_ranksValid;
 };
 
 #endif // __LIBRARY_HH__
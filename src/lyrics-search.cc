@@ -0,0 +1,240 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "lyrics-search.hh"
+
+#include <QtGui>
+#include <QtConcurrentMap>
+
+#include <cstring>
+
+#include "library.hh"
+#include "utils/byte-search.hh"
+
+namespace
+{
+  const int maxHits = 5000;
+  const int maxContextLength = 200;
+
+  // Searches a file, run by the threads of QtConcurrent::mapped
+  class FileSearch
+  {
+  public:
+    typedef QList<CLyricsHit> result_type;
+
+    FileSearch(const QByteArray & pattern, bool caseSensitive)
+      : m_pattern(pattern)
+      , m_caseSensitive(caseSensitive)
+    {}
+
+    QList<CLyricsHit> operator()(const QString & path) const
+    {
+      return CLyricsSearch::searchFile(path, m_pattern, m_caseSensitive);
+    }
+
+  private:
+    QByteArray m_pattern;
+    bool m_caseSensitive;
+  };
+}
+
+//------------------------------------------------------------------------------
+CLyricsSearch::CLyricsSearch(CLibrary *ALibrary, QWidget *parent)
+  : QWidget(parent)
+  , m_library(ALibrary)
+  , m_patternEdit(new QLineEdit)
+  , m_caseSensitiveCheckBox(new QCheckBox(tr("Match &case")))
+  , m_searchButton(new QPushButton(tr("&Search")))
+  , m_results(new QTreeWidget)
+  , m_status(new QLabel)
+  , m_watcher(new QFutureWatcher< QList<CLyricsHit> >(this))
+  , m_time()
+  , m_files(0)
+  , m_hits(0)
+{
+  setWindowTitle(tr("Search"));
+
+  m_results->setColumnCount(3);
+  m_results->setHeaderLabels(QStringList() << tr("File") << tr("Line") << tr("Text"));
+  m_results->setRootIsDecorated(false);
+  m_results->setUniformRowHeights(true);
+  m_results->setAlternatingRowColors(true);
+
+  connect(m_patternEdit, SIGNAL(returnPressed()), SLOT(search()));
+  connect(m_searchButton, SIGNAL(clicked()), SLOT(search()));
+  connect(m_results, SIGNAL(itemActivated(QTreeWidgetItem*, int)),
+	  SLOT(activate(QTreeWidgetItem*)));
+  connect(m_watcher, SIGNAL(resultsReadyAt(int, int)),
+	  SLOT(resultsReady(int, int)));
+  connect(m_watcher, SIGNAL(finished()), SLOT(finished()));
+
+  QHBoxLayout *searchLayout = new QHBoxLayout;
+  searchLayout->addWidget(new QLabel(tr("Songs containing:")));
+  searchLayout->addWidget(m_patternEdit, 1);
+  searchLayout->addWidget(m_caseSensitiveCheckBox);
+  searchLayout->addWidget(m_searchButton);
+
+  QVBoxLayout *layout = new QVBoxLayout;
+  layout->addLayout(searchLayout);
+  layout->addWidget(m_results);
+  layout->addWidget(m_status);
+  setLayout(layout);
+
+  setFocusProxy(m_patternEdit);
+}
+//------------------------------------------------------------------------------
+CLyricsSearch::~CLyricsSearch()
+{
+  m_watcher->cancel();
+  m_watcher->waitForFinished();
+}
+//------------------------------------------------------------------------------
+QList<CLyricsHit> CLyricsSearch::search(const QString & path, const char *data,
+					int size, const QByteArray & pattern,
+					bool caseSensitive)
+{
+  QList<CLyricsHit> hits;
+  CByteSearch searcher(pattern, caseSensitive);
+
+  int line = 1;
+  int counted = 0;
+  int offset = searcher.indexIn(data, size, 0);
+  while (offset >= 0)
+    {
+      // count the lines up to the match
+      const char *newline;
+      while ((newline = (const char *) memchr(data + counted, '\n', offset - counted)))
+	{
+	  ++line;
+	  counted = newline - data + 1;
+	}
+
+      const char *end = (const char *) memchr(data + offset, '\n', size - offset);
+      int lineEnd = end ? end - data : size;
+
+      CLyricsHit hit;
+      hit.path = path;
+      hit.line = line;
+      hit.context = QString::fromUtf8(data + counted, lineEnd - counted).trimmed().left(maxContextLength);
+      hits << hit;
+
+      // a line is reported once
+      if (lineEnd >= size)
+	break;
+      offset = searcher.indexIn(data, size, lineEnd + 1);
+    }
+  return hits;
+}
+//------------------------------------------------------------------------------
+QList<CLyricsHit> CLyricsSearch::searchFile(const QString & path,
+					    const QByteArray & pattern,
+					    bool caseSensitive)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+    return QList<CLyricsHit>();
+
+  // map the file when possible to avoid copying it
+  uchar *data = file.map(0, file.size());
+  if (data)
+    return search(path, (const char *) data, int(file.size()),
+		  pattern, caseSensitive);
+
+  QByteArray content = file.readAll();
+  return search(path, content.constData(), content.size(),
+		pattern, caseSensitive);
+}
+//------------------------------------------------------------------------------
+void CLyricsSearch::search()
+{
+  cancel();
+  m_results->clear();
+  m_hits = 0;
+
+  QString text = m_patternEdit->text();
+  if (text.isEmpty())
+    {
+      m_status->clear();
+      return;
+    }
+
+  QStringList paths;
+  const CBitSet & songs = m_library->songIds();
+  for (int id = songs.nextSetBit(0); id >= 0; id = songs.nextSetBit(id + 1))
+    paths << m_library->song(id).path;
+  m_files = paths.size();
+
+  m_status->setText(tr("Searching %1 songs...").arg(m_files));
+  m_time.start();
+  m_watcher->setFuture(QtConcurrent::mapped(paths, FileSearch(text.toUtf8(), m_caseSensitiveCheckBox->isChecked())));
+}
+//------------------------------------------------------------------------------
+void CLyricsSearch::cancel()
+{
+  if (m_watcher->isRunning())
+    {
+      m_watcher->cancel();
+      m_watcher->waitForFinished();
+    }
+}
+//------------------------------------------------------------------------------
+void CLyricsSearch::resultsReady(int begin, int end)
+{
+  QList<QTreeWidgetItem*> items;
+  for (int i = begin; i < end && m_hits < maxHits; ++i)
+    {
+      foreach (const CLyricsHit & hit, m_watcher->resultAt(i))
+	{
+	  if (m_hits++ >= maxHits)
+	    break;
+
+	  QTreeWidgetItem *item = new QTreeWidgetItem;
+	  item->setText(0, QFileInfo(hit.path).fileName());
+	  item->setToolTip(0, hit.path);
+	  item->setData(0, Qt::UserRole, hit.path);
+	  item->setData(1, Qt::DisplayRole, hit.line);
+	  item->setText(2, hit.context);
+	  items << item;
+	}
+    }
+  m_results->addTopLevelItems(items);
+
+  if (m_hits >= maxHits)
+    {
+      m_watcher->cancel();
+      m_status->setText(tr("More than %1 matches, refine the search.").arg(maxHits));
+    }
+}
+//------------------------------------------------------------------------------
+void CLyricsSearch::finished()
+{
+  if (m_watcher->isCanceled())
+    return;
+
+  m_results->resizeColumnToContents(0);
+  m_status->setText(tr("%1 matching lines in %2 songs searched in %3 ms")
+		    .arg(m_hits).arg(m_files).arg(m_time.elapsed()));
+}
+//------------------------------------------------------------------------------
+void CLyricsSearch::activate(QTreeWidgetItem *item)
+{
+  if (!item)
+    return;
+
+  emit(openRequested(item->data(0, Qt::UserRole).toString(),
+		     item->data(1, Qt::DisplayRole).toInt()));
+}
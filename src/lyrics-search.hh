@@ -0,0 +1,99 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file lyrics-search.hh
+ *
+ * Search of a text in the .sg files of the library.
+ *
+ * Files are scanned concurrently and the matching lines are displayed
+ * as soon as each file has been searched.
+ *
+ */
+#ifndef __LYRICS_SEARCH_HH__
+#define __LYRICS_SEARCH_HH__
+
+#include <QWidget>
+#include <QFutureWatcher>
+#include <QTime>
+
+class CLibrary;
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+/** \struct CLyricsHit "lyrics-search.hh"
+ * \brief CLyricsHit is a line of a song matching the searched text
+ */
+struct CLyricsHit
+{
+  QString path;
+  int line;
+  QString context;
+};
+
+/** \class CLyricsSearch "lyrics-search.hh"
+ * \brief CLyricsSearch is the tab used to search the songs of the library
+ */
+class CLyricsSearch : public QWidget
+{
+  Q_OBJECT
+
+public:
+  CLyricsSearch(CLibrary *library, QWidget *parent = 0);
+  ~CLyricsSearch();
+
+  /// Searches \a data for \a pattern and returns the matching lines.
+  static QList<CLyricsHit> search(const QString & path, const char *data,
+				  int size, const QByteArray & pattern,
+				  bool caseSensitive);
+  /// Searches the file \a path, mapped in memory when possible.
+  static QList<CLyricsHit> searchFile(const QString & path,
+				      const QByteArray & pattern,
+				      bool caseSensitive);
+
+public slots:
+  void search();
+  void cancel();
+
+signals:
+  void openRequested(const QString & path, int line);
+
+private slots:
+  void resultsReady(int begin, int end);
+  void finished();
+  void activate(QTreeWidgetItem *item);
+
+private:
+  CLibrary *m_library;
+  QLineEdit *m_patternEdit;
+  QCheckBox *m_caseSensitiveCheckBox;
+  QPushButton *m_searchButton;
+  QTreeWidget *m_results;
+  QLabel *m_status;
+
+  QFutureWatcher< QList<CLyricsHit> > *m_watcher;
+  QTime m_time;
+  int m_files;
+  int m_hits;
+};
+
+#endif // __LYRICS_SEARCH_HH__
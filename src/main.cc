@@ -17,10 +17,21 @@
 //******************************************************************************
 #include <QApplication>
 #include <QTextCodec>
+#include <QDebug>
 #include "mainwindow.hh"
+#include "tracer.hh"
+#include "startup-profile.hh"
 //******************************************************************************
 int main( int argc, char * argv[] )
 {
+  // --profile-startup prints the duration of the startup phases
+  bool profileStartup = false;
+  for (int i = 1; i < argc; ++i)
+    if (!qstrcmp(argv[i], "--profile-startup"))
+      profileStartup = true;
+  if (profileStartup)
+    CStartupProfile::instance()->start();
+
   //mac os, need to instanciate aplpication fist to get it's path
   QApplication app(argc, argv);
 
@@ -72,8 +83,24 @@ int main( int argc, char * argv[] )
   // move app creation to beggining
   app.installTranslator(&translator);
 
+  // SONGBOOK_TRACE=file records a trace from the start and exports it
+  // when the application exits
+  QString traceFile = QString::fromLocal8Bit(qgetenv("SONGBOOK_TRACE"));
+  if (!traceFile.isEmpty())
+    CTracer::setEnabled(true);
+
   CMainWindow mainWindow;
+  if (profileStartup)
+    {
+      CStartupProfile *profile = CStartupProfile::instance();
+      profile->watchFirstPaint(&mainWindow);
+      QObject::connect(profile, SIGNAL(firstPainted()), profile, SLOT(report()));
+    }
   mainWindow.show();
-  return app.exec();
+  int status = app.exec();
+
+  if (!traceFile.isEmpty() && !CTracer::instance()->exportChromeTrace(traceFile))
+    qWarning() << "unable to export the trace to" << traceFile;
+  return status;
 }
 //******************************************************************************
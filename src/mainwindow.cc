@@ -36,7 +36,20 @@
 #include "dialog-new-song.hh"
 #include "filter-lineedit.hh"
 #include "songSortFilterProxyModel.hh"
+#include "facet-panel.hh"
+#include "song-completer.hh"
+#include "lyrics-search.hh"
+#include "selection-model.hh"
+#include "cover-atlas.hh"
+#include "cover-delegate.hh"
+#include "cover-grid.hh"
+#include "thumbnail-loader.hh"
 #include "tab-widget.hh"
+#include "ui-update-scheduler.hh"
+#include "watchdog.hh"
+#include "tracer.hh"
+#include "startup-profile.hh"
+#include "debug-panel.hh"
 
 using namespace SbUtils;
 
@@ -45,23 +58,58 @@ CMainWindow::CMainWindow()
   : QMainWindow()
   , m_library()
   , m_proxyModel(new CSongSortFilterProxyModel)
+  , m_selectionModel(0)
+  , m_filterLineEdit(new CFilterLineEdit)
+  , m_query()
+  , m_facets(0)
+  , m_lyricsSearch(0)
+  , m_watchdog(0)
+  , m_debugPanel(0)
+  , m_stallThreshold(0)
   , m_songbook(new CSongbook())
   , m_sbInfoSelection(new CLabel)
   , m_sbInfoTitle(new CLabel)
   , m_sbInfoAuthors(new CLabel)
   , m_sbInfoStyle(new CLabel)
   , m_view(new QTableView(this))
+  , m_coverGrid(0)
+  , m_libraryViews(new QStackedWidget)
   , m_progressBar(new QProgressBar(this))
-  , m_cover(new QPixmap)
+  , m_previews(64)
+  , m_currentCover()
+  , m_wantedPreviews()
+#if QT_VERSION >= 0x040600
+  , m_missingCover(QIcon::fromTheme("image-missing").pixmap(128,128))
+#else
+  , m_missingCover()
+#endif
+  , m_pendingCover(128, 128)
 {
   setWindowTitle("Patacrep Songbook Client");
   setWindowIcon(QIcon(":/icons/patacrep.png"));
+  m_pendingCover.fill(Qt::transparent);
 
   m_isToolbarDisplayed = true;
   m_isStatusbarDisplayed = true;
+  m_largeTable = false;
   m_first = true;
 
-  readSettings();
+  {
+    CStartupPhase phase("readSettings");
+    readSettings();
+  }
+
+  // report the operations blocking the interface, including the
+  // initial loading of the library
+  m_debugPanel = new CDebugPanel(this);
+  m_debugPanel->hide();
+  if (m_stallThreshold > 0)
+    {
+      m_watchdog = new CWatchdog(m_stallThreshold, this);
+      connect(m_watchdog, SIGNAL(stallDetected(const QString &, int)),
+	      m_debugPanel, SLOT(addStall(const QString &, int)));
+      m_watchdog->start(QThread::LowPriority);
+    }
 
   // main document and title
   songbook()->setWorkingPath(workingPath());
@@ -76,6 +124,9 @@ CMainWindow::CMainWindow()
   m_log->setMaximumHeight(150);
   m_log->setReadOnly(true);
   new CHighlighter(m_log->document());
+
+  // progress of long operations
+  m_uiScheduler = new CUiUpdateScheduler(statusBar(), progressBar(), m_log, this);
   
   // no data info widget
   m_noDataInfo = new QTextEdit;
@@ -99,8 +150,11 @@ CMainWindow::CMainWindow()
   m_toolbar->setMovable(false);
   this->setUnifiedTitleAndToolBarOnMac(true);
 
-  createActions();
-  createMenus();
+  {
+    CStartupPhase phase("createActions");
+    createActions();
+    createMenus();
+  }
 
   m_toolbar->addAction(m_newAct);
   m_toolbar->addAction(m_openAct);
@@ -112,34 +166,36 @@ CMainWindow::CMainWindow()
   m_toolbar->addAction(m_selectAllAct);
   m_toolbar->addAction(m_unselectAllAct);
   m_toolbar->addAction(m_invertSelectionAct);
-  m_toolbar->addSeparator();
-  m_toolbar->addAction(m_selectEnglishAct);
-  m_toolbar->addAction(m_selectFrenchAct);
-  m_toolbar->addAction(m_selectSpanishAct);
 
   //Connection to database
-  connectDb();
-  refreshLibrary();
+  {
+    CStartupPhase phase("connectDb");
+    connectDb();
+  }
+  {
+    CStartupPhase phase("refreshLibrary");
+    refreshLibrary();
+  }
 
   // filtering related widgets
-  CFilterLineEdit *filterLineEdit = new CFilterLineEdit;
-  m_proxyModel->setFilterKeyColumn(-1);
-  filterLineEdit->setVisible(true);
-  connect(filterLineEdit, SIGNAL(textChanged(QString)),
+  m_filterLineEdit->setVisible(true);
+  m_filterLineEdit->setToolTip(tr("Filter songs, for example: "
+				  "artist:brel lang:french lilypond:yes album:\"...\""));
+  connect(m_filterLineEdit, SIGNAL(textChanged(QString)),
 	  this, SLOT(filterChanged()));
 
   QWidget* stretchWidget = new QWidget;
   stretchWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
   m_toolbar->addWidget(stretchWidget);
-  m_toolbar->addWidget(filterLineEdit);
+  m_toolbar->addWidget(m_filterLineEdit);
   m_toolbar->setContextMenuPolicy(Qt::PreventContextMenu);
 
-  //artist autocompletion in the filter bar
-  QCompleter *completer = new QCompleter;
-  completer->setModel(library());
-  completer->setCaseSensitivity(Qt::CaseInsensitive);
-  completer->setCompletionMode(QCompleter::InlineCompletion);
-  filterLineEdit->setCompleter(completer);
+  //autocompletion of the last term in the filter bar
+  CSongCompleter *completer = new CSongCompleter(library()->completion(),
+						 CCompletionService::AllSources,
+						 m_filterLineEdit);
+  completer->setQueryMode(true);
+  m_filterLineEdit->setCompleter(completer);
 
   addToolBar(m_toolbar);
   
@@ -157,8 +213,11 @@ CMainWindow::CMainWindow()
   leftLayout->addLayout(songInfo());
   leftLayout->addWidget(new QLabel(tr("<b>Songbook</b>")));
   leftLayout->addLayout(songbookInfo());
-  leftLayout->addStretch();
-  dataLayout->addWidget(view());
+  leftLayout->addWidget(new QLabel(tr("<b>Browse</b>")));
+  leftLayout->addWidget(m_facets, 1);
+  m_libraryViews->addWidget(view());
+  m_libraryViews->addWidget(coverGrid());
+  dataLayout->addWidget(m_libraryViews);
   dataLayout->addWidget(m_noDataInfo);
   centerLayout->addLayout(leftLayout);
   centerLayout->addLayout(dataLayout);
@@ -189,10 +248,16 @@ CMainWindow::CMainWindow()
   progressBar()->hide();
   statusBar()->addPermanentWidget(progressBar());
 
-  applySettings();
-  selectionChanged();
-  songbook()->panel();
-  updateSongbookLabels();
+  {
+    CStartupPhase phase("applySettings");
+    applySettings();
+    selectionChanged();
+  }
+  {
+    CStartupPhase phase("songbook panel");
+    songbook()->panel();
+    updateSongbookLabels();
+  }
 }
 //------------------------------------------------------------------------------
 CMainWindow::~CMainWindow()
@@ -225,6 +290,9 @@ void CMainWindow::readSettings()
   QSettings settings;
 
   resize(settings.value("mainWindow/size", QSize(800,600)).toSize());
+  m_largeTable = settings.value("mainWindow/largeTable", false).toBool();
+  // turns of the event loop longer than this are reported, 0 disables
+  m_stallThreshold = settings.value("debug/stallThreshold", 250).toInt();
 
   setWorkingPath( settings.value("workingPath", QString("%1/songbook").arg(QDir::home().path())).toString() );
 
@@ -244,6 +312,7 @@ void CMainWindow::writeSettings()
 {
   QSettings settings;
   settings.setValue("mainWindow/size", size());
+  settings.setValue("mainWindow/largeTable", m_largeTable);
 }
 //------------------------------------------------------------------------------
 void CMainWindow::applySettings()
@@ -255,6 +324,8 @@ void CMainWindow::applySettings()
   view()->setColumnHidden(4,!m_displayColumnAlbum);
   view()->setColumnHidden(5,!m_displayColumnCover);
   view()->setColumnHidden(6,!m_displayColumnLang);
+  view()->setColumnHidden(7,true);
+  view()->setColumnHidden(8,true);
   view()->setColumnWidth(0,250);
   view()->setColumnWidth(1,350);
   view()->setColumnWidth(4,250);
@@ -300,9 +371,9 @@ void CMainWindow::updateSongbookLabels()
 //------------------------------------------------------------------------------
 void CMainWindow::updateView()
 {
-  view()->sortByColumn(1, Qt::AscendingOrder);
+  // artist then title
   view()->sortByColumn(0, Qt::AscendingOrder);
-  view()->show();
+  m_libraryViews->currentWidget()->show();
 }
 //------------------------------------------------------------------------------
 void CMainWindow::filterChanged()
@@ -311,8 +382,8 @@ void CMainWindow::filterChanged()
 
   if (QLineEdit *lineEdit = qobject_cast< QLineEdit* >(object))
     {
-      QRegExp expression = QRegExp(lineEdit->text(), Qt::CaseInsensitive, QRegExp::FixedString);
-      m_proxyModel->setFilterRegExp(expression);
+      m_query = CSongQuery(lineEdit->text());
+      applyFilter();
     }
   else
     {
@@ -320,6 +391,28 @@ void CMainWindow::filterChanged()
     }
 }
 //------------------------------------------------------------------------------
+void CMainWindow::applyFilter()
+{
+  CWatchdogTag tag("applyFilter");
+  SB_TRACE("CMainWindow::applyFilter");
+  if (m_query.isEmpty())
+    {
+      m_proxyModel->clearSongFilter();
+      m_facets->clearResult();
+    }
+  else
+    {
+      CBitSet songs = library()->search(m_query);
+      m_proxyModel->setSongFilter(songs);
+      m_facets->setResult(songs);
+    }
+}
+//------------------------------------------------------------------------------
+void CMainWindow::refineFilter(const QString & term)
+{
+  m_filterLineEdit->setText(QString("%1 %2").arg(m_filterLineEdit->text()).arg(term).trimmed());
+}
+//------------------------------------------------------------------------------
 void CMainWindow::selectionChanged()
 {
   QItemSelection invalid;
@@ -328,7 +421,7 @@ void CMainWindow::selectionChanged()
 //------------------------------------------------------------------------------
 void CMainWindow::selectionChanged(const QItemSelection & , const QItemSelection & )
 {
-  m_sbNbSelected = selectionModel()->selectedRows().size();
+  m_sbNbSelected = m_selectionModel->selectedCount();
   m_sbNbTotal = library()->rowCount();
   m_sbInfoSelection->setText(QString(tr("%1/%2"))
 			     .arg(m_sbNbSelected).arg(m_sbNbTotal) );
@@ -420,28 +513,25 @@ void CMainWindow::createActions()
   m_invertSelectionAct->setStatusTip(tr("Invert currently selected songs in the library"));
   connect(m_invertSelectionAct, SIGNAL(triggered()), SLOT(invertSelection()));
 
-  m_selectEnglishAct = new QAction(tr("english"), this);
-  m_selectEnglishAct->setStatusTip(tr("Select/Unselect songs in english"));
-  m_selectEnglishAct->setIcon(QIcon::fromTheme("flag-en",QIcon(":/icons/en.png")));
-  m_selectEnglishAct->setCheckable(true);
-  connect(m_selectEnglishAct, SIGNAL(triggered(bool)), SLOT(selectLanguage(bool)));
-
-  m_selectFrenchAct = new QAction(tr("french"), this);
-  m_selectFrenchAct->setStatusTip(tr("Select/Unselect songs in french"));
-  m_selectFrenchAct->setIcon(QIcon::fromTheme("flag-fr",QIcon(":/icons/fr.png")));
-  m_selectFrenchAct->setCheckable(true);
-  connect(m_selectFrenchAct, SIGNAL(triggered(bool)), SLOT(selectLanguage(bool)));
-
-  m_selectSpanishAct = new QAction(tr("spanish"), this);
-  m_selectSpanishAct->setStatusTip(tr("Select/Unselect songs in spanish"));
-  m_selectSpanishAct->setIcon(QIcon::fromTheme("flag-es",QIcon(":/icons/es.png")));
-  m_selectSpanishAct->setCheckable(true);
-  connect(m_selectSpanishAct, SIGNAL(triggered(bool)), SLOT(selectLanguage(bool)));
+  m_selectMatchingAct = new QAction(tr("Select matching"), this);
+  m_selectMatchingAct->setStatusTip(tr("Add the songs matching the filter to the selection"));
+  connect(m_selectMatchingAct, SIGNAL(triggered()), SLOT(selectMatching()));
 
   m_adjustColumnsAct = new QAction(tr("Auto Adjust Columns"), this);
   m_adjustColumnsAct->setStatusTip(tr("Adjust columns to contents"));
   connect(m_adjustColumnsAct, SIGNAL(triggered()),
-          view(), SLOT(resizeColumnsToContents()));
+          this, SLOT(adjustColumns()));
+
+  m_largeTableAct = new QAction(tr("Large Table Mode"), this);
+  m_largeTableAct->setStatusTip(tr("Assume uniform rows and size columns from a sample of the songs"));
+  m_largeTableAct->setCheckable(true);
+  m_largeTableAct->setChecked(m_largeTable);
+  connect(m_largeTableAct, SIGNAL(toggled(bool)), this, SLOT(setLargeTable(bool)));
+
+  m_coverGridAct = new QAction(tr("Cover Grid"), this);
+  m_coverGridAct->setStatusTip(tr("Display the library as a grid of covers"));
+  m_coverGridAct->setCheckable(true);
+  connect(m_coverGridAct, SIGNAL(toggled(bool)), SLOT(setCoverGridDisplayed(bool)));
 
   m_refreshLibraryAct = new QAction(tr("Update"), this);
   m_refreshLibraryAct->setStatusTip(tr("Update current song list from \".sg\" files"));
@@ -481,6 +571,25 @@ void CMainWindow::createActions()
   m_checkerAct->setStatusTip(tr("Check for common mistakes in songs (e.g spelling, chords, LaTeX typo ...)"));
   connect(m_checkerAct, SIGNAL(triggered()), m_builder, SLOT(dialog()));
 
+  m_lyricsSearchAct = new QAction(tr("Search in songs"), this);
+  m_lyricsSearchAct->setShortcut(tr("Ctrl+Shift+F"));
+  m_lyricsSearchAct->setStatusTip(tr("Find the songs containing a text"));
+  connect(m_lyricsSearchAct, SIGNAL(triggered()), SLOT(lyricsSearch()));
+
+  m_debugPanelAct = new QAction(tr("Debug panel"), this);
+  m_debugPanelAct->setStatusTip(tr("Show the operations that blocked the interface and the metrics"));
+  connect(m_debugPanelAct, SIGNAL(triggered()), SLOT(debugPanel()));
+
+  m_traceAct = new QAction(tr("Record trace"), this);
+  m_traceAct->setStatusTip(tr("Record the duration of the operations"));
+  m_traceAct->setCheckable(true);
+  m_traceAct->setChecked(CTracer::isEnabled());
+  connect(m_traceAct, SIGNAL(toggled(bool)), SLOT(setTracing(bool)));
+
+  m_exportTraceAct = new QAction(tr("Export trace..."), this);
+  m_exportTraceAct->setStatusTip(tr("Save the recorded trace in the Chrome trace format"));
+  connect(m_exportTraceAct, SIGNAL(triggered()), SLOT(exportTrace()));
+
   m_buildAct = new QAction(tr("Build PDF"), this);
 #if QT_VERSION >= 0x040600
   m_buildAct->setIcon(QIcon::fromTheme("document-export"));
@@ -530,7 +639,6 @@ void CMainWindow::connectDb()
   QString path = QString("%1/.cache/songbook-client").arg(QDir::home().path());
   QDir dbdir; dbdir.mkpath( path );
   QString dbpath = QString("%1/patacrep.db").arg(path);
-  bool exist = QFile::exists(dbpath); 
 
   QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
   db.setDatabaseName(dbpath);
@@ -541,26 +649,28 @@ void CMainWindow::connectDb()
 			       "This application needs SQLite support. "
 			       "Click Cancel to exit."), QMessageBox::Cancel);
     }
-  if (!exist)
-    {
-      QSqlQuery query;
-      query.exec("create table songs ( artist text, "
-		 "title text, "
-		 "lilypond bool, "
-		 "path text, "
-		 "album text, "
-		 "cover text, "
-		 "lang text)");
-    }
+  CLibrary::createTables(db);
 
   // Initialize the song library
   m_library = new CLibrary(this);
   library()->setWorkingPath(workingPath());
 
+  m_facets = new CFacetPanel(library());
+  connect(m_facets, SIGNAL(filterRequested(const QString &)),
+	  this, SLOT(refineFilter(const QString &)));
+  connect(m_facets, SIGNAL(selectionRequested(const CBitSet &, bool)),
+	  this, SLOT(selectSongs(const CBitSet &, bool)));
+
   m_proxyModel->setSourceModel(library());
   m_proxyModel->setDynamicSortFilter(true);
 
   view()->setModel(m_proxyModel);
+  QItemSelectionModel *defaultSelectionModel = view()->selectionModel();
+  m_selectionModel = new CSelectionModel(m_proxyModel, library());
+  view()->setSelectionModel(m_selectionModel);
+  delete defaultSelectionModel;
+  connect(m_selectionModel, SIGNAL(selectedSongsChanged()),
+	  this, SLOT(selectionChanged()));
   view()->setShowGrid( false );
   view()->setAlternatingRowColors(true);
   view()->setSelectionMode(QAbstractItemView::MultiSelection);
@@ -568,22 +678,74 @@ void CMainWindow::connectDb()
   view()->setEditTriggers(QAbstractItemView::NoEditTriggers);
   view()->setSortingEnabled(true);
   view()->verticalHeader()->setVisible(false);
+  view()->setItemDelegateForColumn(5, new CCoverDelegate(library(), view()));
+  setLargeTable(m_largeTable);
+
+  m_coverGrid = new CCoverGrid(library());
+  m_coverGrid->setModel(m_proxyModel);
+  m_coverGrid->setModelColumn(5);
+  QItemSelectionModel *gridSelectionModel = m_coverGrid->selectionModel();
+  m_coverGrid->setSelectionModel(m_selectionModel);
+  delete gridSelectionModel;
+
+  connect(library()->thumbnails(), SIGNAL(previewReady(const QString &, const QImage &)),
+	  this, SLOT(showPreview(const QString &, const QImage &)));
+  connect(view()->verticalScrollBar(), SIGNAL(valueChanged(int)),
+	  this, SLOT(dropHiddenCovers()));
+  connect(m_coverGrid->verticalScrollBar(), SIGNAL(valueChanged(int)),
+	  this, SLOT(dropHiddenPreviews()));
 
+  connect(library(), SIGNAL(wasModified()),
+          this, SLOT(applyFilter()));
   connect(library(), SIGNAL(wasModified()),
           this, SLOT(updateView()));
   connect(library(), SIGNAL(wasModified()),
           this, SLOT(selectionChanged()));
 }
 //------------------------------------------------------------------------------
+void CMainWindow::dropHiddenCovers()
+{
+  int first = view()->rowAt(0);
+  if (first < 0)
+    return;
+
+  int last = view()->rowAt(view()->viewport()->height() - 1);
+  if (last < 0)
+    last = m_proxyModel->rowCount() - 1;
+
+  // keep the covers of the rows one page away from the viewport
+  int page = last - first + 1;
+  first = qMax(0, first - page);
+  last = qMin(m_proxyModel->rowCount() - 1, last + page);
+
+  QSet<QString> covers;
+  for (int row = first; row <= last; ++row)
+    {
+      int id = library()->songIdAt(m_proxyModel->mapToSource(m_proxyModel->index(row, 0)).row());
+      if (id >= 0 && library()->song(id).hasCover)
+	covers.insert(library()->song(id).coverPath);
+    }
+  library()->thumbnails()->retainOnly(covers);
+}
+//------------------------------------------------------------------------------
+void CMainWindow::dropHiddenPreviews()
+{
+  QSet<QString> covers = m_coverGrid->visibleCovers();
+  covers.unite(m_wantedPreviews);
+  library()->thumbnails()->retainPreviews(covers);
+}
+//------------------------------------------------------------------------------
 void CMainWindow::rebuildLibrary()
 {
   //Drop table songs and recreate
-  QSqlQuery query("delete from songs");
+  library()->removeAllSongs();
   refreshLibrary();
 }
 //------------------------------------------------------------------------------
 void CMainWindow::refreshLibrary()
 {
+  CWatchdogTag tag("refreshLibrary");
+  SB_TRACE("CMainWindow::refreshLibrary");
   QStringList filter = QStringList() << "*.sg";
   QString path = QString("%1/songs/").arg(workingPath());
   
@@ -594,14 +756,9 @@ void CMainWindow::refreshLibrary()
       ++count;
       i.next();
     }
-  progressBar()->show();
-  progressBar()->setTextVisible(true);
-  progressBar()->setRange(0, count);
-
+  uiScheduler()->beginTask(tr("Inserting songs"), count);
   library()->retrieveSongs();
-  progressBar()->setTextVisible(false);
-  progressBar()->hide();
-  statusBar()->showMessage(tr("Building database from \".sg\" files completed."));
+  uiScheduler()->endTask(tr("Building database from \".sg\" files completed."));
 }
 //------------------------------------------------------------------------------
 void CMainWindow::closeEvent(QCloseEvent *event)
@@ -627,6 +784,10 @@ void CMainWindow::createMenus()
   m_editMenu->addAction(m_selectAllAct);
   m_editMenu->addAction(m_unselectAllAct);
   m_editMenu->addAction(m_invertSelectionAct);
+  m_editMenu->addAction(m_selectMatchingAct);
+  m_languageMenu = m_editMenu->addMenu(tr("Select language"));
+  connect(m_languageMenu, SIGNAL(aboutToShow()), SLOT(updateLanguageMenu()));
+  connect(m_languageMenu, SIGNAL(triggered(QAction*)), SLOT(selectLanguage(QAction*)));
   m_editMenu->addSeparator();
   m_editMenu->addAction(m_preferencesAct);
 
@@ -641,10 +802,16 @@ void CMainWindow::createMenus()
   m_viewMenu->addAction(m_toolbarViewAct);
   m_viewMenu->addAction(m_statusbarViewAct);
   m_viewMenu->addAction(m_adjustColumnsAct);
+  m_viewMenu->addAction(m_largeTableAct);
+  m_viewMenu->addAction(m_coverGridAct);
 
   m_viewMenu = menuBar()->addMenu(tr("&Tools"));
   m_viewMenu->addAction(m_resizeCoversAct);
   m_viewMenu->addAction(m_checkerAct);
+  m_viewMenu->addAction(m_lyricsSearchAct);
+  m_viewMenu->addAction(m_debugPanelAct);
+  m_viewMenu->addAction(m_traceAct);
+  m_viewMenu->addAction(m_exportTraceAct);
 
   m_helpMenu = menuBar()->addMenu(tr("&Help"));
   m_helpMenu->addAction(m_documentationAct);
@@ -693,9 +860,11 @@ QGridLayout * CMainWindow::songInfo()
   m_mapper->addMapping(albumLabel, 4, QByteArray("text"));
   updateCover(QModelIndex());
 
-  connect(view(), SIGNAL(clicked(const QModelIndex &)),
+  // the table and the grid share the selection model, which follows
+  // the clicks and the keyboard navigation of both
+  connect(m_selectionModel, SIGNAL(currentRowChanged(const QModelIndex &, const QModelIndex &)),
           m_mapper, SLOT(setCurrentModelIndex(const QModelIndex &)));
-  connect(view(), SIGNAL(clicked(const QModelIndex &)),
+  connect(m_selectionModel, SIGNAL(currentRowChanged(const QModelIndex &, const QModelIndex &)),
           SLOT(updateCover(const QModelIndex &)));
 
   return layout;
@@ -729,34 +898,74 @@ QGridLayout * CMainWindow::songbookInfo()
 //------------------------------------------------------------------------------
 void CMainWindow::updateCover(const QModelIndex & index)
 {
-  if (!selectionModel()->hasSelection())
+  CWatchdogTag tag("updateCover");
+  if (!index.isValid())
     {
-#if QT_VERSION >= 0x040600
-      m_cover = new QPixmap(QIcon::fromTheme("image-missing").pixmap(128,128));
-#else
-      m_cover = new QPixmap;
-#endif
-      m_coverLabel.setPixmap(*m_cover);
+      m_currentCover.clear();
+      m_wantedPreviews.clear();
+      dropHiddenPreviews();
+      m_coverLabel.setPixmap(m_missingCover);
       return;
     }
 
-  // do not retrieve last clicked item but last selected item
-  QModelIndex lastIndex = selectionModel()->selectedRows().last();
-  selectionModel()->setCurrentIndex(lastIndex, QItemSelectionModel::NoUpdate);
-  if (lastIndex != index)
-    m_mapper->setCurrentModelIndex(lastIndex);
+  // the previews of the songs shown before are no longer decoded
+  int row = index.row();
+  QString previous = previewCover(row - 1);
+  QString next = previewCover(row + 1);
+  m_currentCover = previewCover(row);
+  m_wantedPreviews.clear();
+  m_wantedPreviews << previous << next << m_currentCover;
+  m_wantedPreviews.remove(QString());
+  dropHiddenPreviews();
+
+  // the neighbours are requested first so that the current cover
+  // is decoded before them
+  prefetchPreview(previous);
+  prefetchPreview(next);
+
+  if (m_currentCover.isEmpty())
+    {
+      m_coverLabel.setPixmap(m_missingCover);
+      return;
+    }
 
-  QString coverpath = library()->record(m_proxyModel->mapToSource(lastIndex).row()).field("cover").value().toString();
-  if (QFile::exists(coverpath))
-    m_cover->load(coverpath);
+  // an empty cover of the same size is shown until this one is
+  // decoded, rather than the cover of another song
+  if (QPixmap *preview = m_previews.object(m_currentCover))
+    {
+      m_coverLabel.setPixmap(*preview);
+    }
   else
-#if QT_VERSION >= 0x040600
-    m_cover = new QPixmap(QIcon::fromTheme("image-missing").pixmap(128,128));
-#else
-  m_cover = new QPixmap;
-#endif
+    {
+      m_coverLabel.setPixmap(m_pendingCover);
+      library()->thumbnails()->requestPreview(m_currentCover);
+    }
+}
+//------------------------------------------------------------------------------
+QString CMainWindow::previewCover(int row) const
+{
+  if (row < 0 || row >= m_proxyModel->rowCount())
+    return QString();
+
+  int id = library()->songIdAt(m_proxyModel->mapToSource(m_proxyModel->index(row, 0)).row());
+  if (id < 0 || !library()->song(id).hasCover)
+    return QString();
 
-  m_coverLabel.setPixmap(m_cover->scaled(128, 128, Qt::IgnoreAspectRatio));
+  return library()->song(id).coverPath;
+}
+//------------------------------------------------------------------------------
+void CMainWindow::prefetchPreview(const QString & cover)
+{
+  if (!cover.isEmpty() && !m_previews.contains(cover))
+    library()->thumbnails()->requestPreview(cover);
+}
+//------------------------------------------------------------------------------
+void CMainWindow::showPreview(const QString & cover, const QImage & image)
+{
+  QPixmap preview = image.isNull() ? m_missingCover : QPixmap::fromImage(image);
+  if (cover == m_currentCover)
+    m_coverLabel.setPixmap(preview);
+  m_previews.insert(cover, new QPixmap(preview));
 }
 //------------------------------------------------------------------------------
 void CMainWindow::preferences()
@@ -786,64 +995,82 @@ void CMainWindow::about()
 //------------------------------------------------------------------------------
 void CMainWindow::selectAll()
 {
-  view()->selectAll();
+  fetchAllRows();
+  m_selectionModel->selectVisibleSongs();
   view()->setFocus();
 }
 //------------------------------------------------------------------------------
 void CMainWindow::unselectAll()
 {
-  view()->clearSelection();
+  m_selectionModel->clearSongs();
 }
 //------------------------------------------------------------------------------
 void CMainWindow::invertSelection()
 {
-  QModelIndexList indexes = selectionModel()->selectedRows();
-  QModelIndex index;
-
-  view()->selectAll();
-
-  foreach(index, indexes)
-    {
-      selectionModel()->select(index, QItemSelectionModel::Deselect | QItemSelectionModel::Rows);
-    }
+  fetchAllRows();
+  m_selectionModel->invertVisibleSongs();
 }
 //------------------------------------------------------------------------------
-void CMainWindow::selectLanguage(bool selection)
+void CMainWindow::selectMatching()
 {
-  QString language = qobject_cast< QAction* >(QObject::sender())->text();
-  QList<QModelIndex> indexes;
-  QModelIndex index;
-
-  indexes = m_proxyModel->match(m_proxyModel->index(0,6), Qt::ToolTipRole, language, -1);
-
-  QItemSelectionModel::SelectionFlags flag = (selection ? QItemSelectionModel::Select : QItemSelectionModel::Deselect) | QItemSelectionModel::Rows;
-
-  foreach(index, indexes)
-    {
-      selectionModel()->select(index, flag);
-    }  
+  selectMatching(m_query);
   view()->setFocus();
 }
 //------------------------------------------------------------------------------
-QStringList CMainWindow::getSelectedSongs()
+void CMainWindow::selectMatching(const CSongQuery & query, bool selection)
 {
-  QStringList songsPath;
-  QModelIndexList indexes = selectionModel()->selectedRows();
-  QModelIndex index;
-
-  qSort(indexes.begin(), indexes.end());
+  selectSongs(library()->search(query), selection);
+}
+//------------------------------------------------------------------------------
+void CMainWindow::selectSongs(const CBitSet & songs, bool selection)
+{
+  fetchAllRows();
+  m_selectionModel->selectSongs(songs, selection);
+  view()->setFocus();
+}
+//------------------------------------------------------------------------------
+void CMainWindow::updateLanguageMenu()
+{
+  m_languageMenu->clear();
 
-  foreach(index, indexes)
+  const CBitSet & selected = m_selectionModel->selectedSongs();
+  foreach (const QString & language, library()->languages())
     {
-      songsPath << library()->record(m_proxyModel->mapToSource(index).row()).field("path").value().toString();
+      CBitSet songs = library()->languageSongs(language);
+      QAction *action = m_languageMenu->addAction(language);
+      action->setData(language);
+      action->setStatusTip(tr("Select/Unselect songs in %1").arg(language));
+      action->setCheckable(true);
+      action->setChecked((songs & selected).count() == songs.count());
+
+      QPixmap flag = library()->languageFlag(language);
+      if (!flag.isNull())
+	action->setIcon(QIcon(flag));
     }
 
-  return songsPath;
+  if (m_languageMenu->isEmpty())
+    m_languageMenu->addAction(tr("No song"))->setEnabled(false);
+}
+//------------------------------------------------------------------------------
+void CMainWindow::selectLanguage(QAction *action)
+{
+  QString language = action->data().toString();
+  if (language.isEmpty())
+    return;
+
+  selectSongs(library()->languageSongs(language), action->isChecked());
+}
+//------------------------------------------------------------------------------
+QStringList CMainWindow::getSelectedSongs()
+{
+  // includes the songs hidden by the filter
+  return library()->paths(m_selectionModel->selectedSongs());
 }
 //------------------------------------------------------------------------------
 void CMainWindow::build()
 {
-  if(getSelectedSongs().isEmpty())
+  CWatchdogTag tag("build");
+  if(m_selectionModel->selectedCount() == 0)
     {
       if(QMessageBox::question(this, windowTitle(), 
 			       QString(tr("You did not select any song. \n "
@@ -856,7 +1083,9 @@ void CMainWindow::build()
 	selectAll();
     }
   
+  CTraceScope saveTrace("build: save");
   save(true);
+  saveTrace.finish();
   
   switch(songbook()->checkFilename())
     {
@@ -876,9 +1105,11 @@ void CMainWindow::build()
   m_builder = new CMakeSongbook(this);
 
   //force a make clean
+  CTraceScope cleanTrace("build: clean");
   m_builder->setProcessOptions(QStringList() << "clean");
   m_builder->action();
   m_builder->process()->waitForFinished();
+  cleanTrace.finish();
   
   m_builder->setProcessOptions(QStringList() << target);
   m_builder->action();
@@ -896,21 +1127,26 @@ void CMainWindow::open()
                                                   tr("Open"),
                                                   workingPath(),
                                                   tr("Songbook (*.sb)"));
+  open(filename);
+}
+//------------------------------------------------------------------------------
+void CMainWindow::open(const QString & filename)
+{
   songbook()->load(filename);
   QStringList songlist = songbook()->songs();
   QString path = QString("%1/songs/").arg(workingPath());
   songlist.replaceInStrings(QRegExp("^"),path);
 
-  view()->clearSelection();
-
-  QList<QModelIndex> indexes;
+  CBitSet songs(library()->songIds().size());
   QString str;
   foreach(str, songlist)
     {
-      indexes = m_proxyModel->match( m_proxyModel->index(0,3), Qt::MatchExactly, str );
-      if (!indexes.isEmpty())
-        selectionModel()->select(indexes[0], QItemSelectionModel::Select | QItemSelectionModel::Rows);
+      int id = library()->songId(str);
+      if (id >= 0)
+	songs.setBit(id);
     }
+  fetchAllRows();
+  m_selectionModel->setSelectedSongs(songs);
 
   updateTitle(songbook()->filename());
 }
@@ -982,6 +1218,11 @@ void CMainWindow::setWorkingPath(QString dirname)
   m_first = false;
 }
 //------------------------------------------------------------------------------
+CUiUpdateScheduler * CMainWindow::uiScheduler() const
+{
+  return m_uiScheduler;
+}
+//------------------------------------------------------------------------------
 QProgressBar * CMainWindow::progressBar() const
 {
   return m_progressBar;
@@ -997,16 +1238,100 @@ QTableView * CMainWindow::view() const
   return m_view;
 }
 //------------------------------------------------------------------------------
+CCoverGrid * CMainWindow::coverGrid() const
+{
+  return m_coverGrid;
+}
+//------------------------------------------------------------------------------
+void CMainWindow::setLargeTable(bool value)
+{
+  m_largeTable = value;
+  library()->setSizeHintsEnabled(!value);
+
+  // rows are not measured, they are high enough for a cover
+  QHeaderView *header = view()->verticalHeader();
+  if (value)
+    {
+      header->setDefaultSectionSize(qMax(int(CCoverAtlas::SlotSize),
+					 view()->fontMetrics().height()) + 4);
+      header->setResizeMode(QHeaderView::Fixed);
+    }
+  else
+    {
+      header->setResizeMode(QHeaderView::Interactive);
+    }
+}
+//------------------------------------------------------------------------------
+void CMainWindow::adjustColumns()
+{
+  if (!m_largeTable)
+    {
+      view()->resizeColumnsToContents();
+      return;
+    }
+
+  // sample rows spread over the whole table and the visible rows
+  const int SampleSize = 256;
+  int rows = m_proxyModel->rowCount();
+  QVector<int> sample;
+  int step = qMax(1, rows / SampleSize);
+  for (int row = 0; row < rows; row += step)
+    sample << row;
+
+  int first = view()->rowAt(0);
+  if (first >= 0)
+    {
+      int last = view()->rowAt(view()->viewport()->height() - 1);
+      if (last < 0)
+	last = rows - 1;
+      for (int row = first; row <= last; ++row)
+	sample << row;
+    }
+
+  QStyleOptionViewItemV4 option;
+  option.initFrom(view());
+  option.font = view()->font();
+  option.fontMetrics = view()->fontMetrics();
+  option.decorationSize = QSize(CCoverAtlas::SlotSize, CCoverAtlas::SlotSize);
+
+  for (int column = 0; column < m_proxyModel->columnCount(); ++column)
+    {
+      if (view()->isColumnHidden(column))
+	continue;
+
+      int width = view()->horizontalHeader()->sectionSizeHint(column);
+      foreach (int row, sample)
+	{
+	  QModelIndex index = m_proxyModel->index(row, column);
+	  width = qMax(width, view()->itemDelegate(index)->sizeHint(option, index).width());
+	}
+      view()->setColumnWidth(column, width);
+    }
+}
+//------------------------------------------------------------------------------
+void CMainWindow::setCoverGridDisplayed(bool value)
+{
+  if (value)
+    m_libraryViews->setCurrentWidget(coverGrid());
+  else
+    m_libraryViews->setCurrentWidget(view());
+  m_libraryViews->currentWidget()->setFocus();
+}
+//------------------------------------------------------------------------------
 CLibrary * CMainWindow::library() const
 {
   return m_library;
 }
 //------------------------------------------------------------------------------
-QItemSelectionModel * CMainWindow::selectionModel()
+void CMainWindow::fetchAllRows()
 {
   while (library()->canFetchMore())
     library()->fetchMore();
-
+}
+//------------------------------------------------------------------------------
+QItemSelectionModel * CMainWindow::selectionModel()
+{
+  fetchAllRows();
   return view()->selectionModel();
 }
 //------------------------------------------------------------------------------
@@ -1053,6 +1378,55 @@ void CMainWindow::songEditor(const QString &path, const QString &title)
   m_editors.insert(path, editor);
 }
 //------------------------------------------------------------------------------
+void CMainWindow::lyricsSearch()
+{
+  if (!m_lyricsSearch)
+    {
+      m_lyricsSearch = new CLyricsSearch(library(), this);
+      connect(m_lyricsSearch, SIGNAL(openRequested(const QString &, int)),
+	      this, SLOT(openSongAtLine(const QString &, int)));
+    }
+
+  if (m_mainWidget->indexOf(m_lyricsSearch) < 0)
+    m_mainWidget->addTab(m_lyricsSearch);
+  m_mainWidget->setCurrentWidget(m_lyricsSearch);
+  m_lyricsSearch->setFocus();
+}
+//------------------------------------------------------------------------------
+void CMainWindow::debugPanel()
+{
+  if (m_mainWidget->indexOf(m_debugPanel) < 0)
+    m_mainWidget->addTab(m_debugPanel);
+  m_mainWidget->setCurrentWidget(m_debugPanel);
+}
+//------------------------------------------------------------------------------
+void CMainWindow::setTracing(bool value)
+{
+  CTracer::setEnabled(value);
+}
+//------------------------------------------------------------------------------
+void CMainWindow::exportTrace()
+{
+  QString filename = QFileDialog::getSaveFileName(this, tr("Export trace"),
+						  QString("%1/trace.json").arg(QDir::homePath()),
+						  tr("Trace (*.json)"));
+  if (filename.isEmpty())
+    return;
+
+  if (CTracer::instance()->exportChromeTrace(filename))
+    statusBar()->showMessage(tr("Trace exported to %1").arg(filename));
+  else
+    statusBar()->showMessage(tr("Unable to export the trace to %1").arg(filename));
+}
+//------------------------------------------------------------------------------
+void CMainWindow::openSongAtLine(const QString &path, int line)
+{
+  int id = library()->songId(path);
+  songEditor(path, id < 0 ? QString() : library()->song(id).title);
+  if (m_editors.contains(path))
+    m_editors[path]->goToLine(line);
+}
+//------------------------------------------------------------------------------
 void CMainWindow::newSong()
 {
   CDialogNewSong *dialog = new CDialogNewSong(this);
@@ -1096,8 +1470,8 @@ void CMainWindow::deleteSong(const QString &path)
 	  QDir dir;
 	  dir.rmdir(tmp); //remove dir if empty
 	  //once deleted move selection in the model
-	  updateCover(selectionModel()->currentIndex());
-	  m_mapper->setCurrentModelIndex(selectionModel()->currentIndex());
+	  updateCover(m_selectionModel->currentIndex());
+	  m_mapper->setCurrentModelIndex(m_selectionModel->currentIndex());
 	}
     }
 }
@@ -1121,6 +1495,15 @@ void CMainWindow::closeTab(int index)
       m_editors.remove(editor->path());
       m_mainWidget->closeTab(index);
     }
+  else if (m_lyricsSearch && m_mainWidget->widget(index) == m_lyricsSearch)
+    {
+      m_lyricsSearch->cancel();
+      m_mainWidget->closeTab(index);
+    }
+  else if (m_mainWidget->widget(index) == m_debugPanel)
+    {
+      m_mainWidget->closeTab(index);
+    }
 }
 //------------------------------------------------------------------------------
 void CMainWindow::changeTab(int index)
@@ -28,6 +28,8 @@
 
 #include <QtGui>
 
+#include "song-query.hh"
+
 class CSongbook;
 class CLibrary;
 class CTabWidget;
@@ -36,6 +38,16 @@ class CSongEditor;
 class CBuildEngine;
 class CLabel;
 class CTabWidget;
+class CFilterLineEdit;
+class CSongSortFilterProxyModel;
+class CFacetPanel;
+class CLyricsSearch;
+class CSelectionModel;
+class CCoverGrid;
+class CUiUpdateScheduler;
+class CWatchdog;
+class CDebugPanel;
+class CBitSet;
 
 /** \class CMainWindow "mainWindow.hh"
  * \brief CMainWindow is the base class of the application
@@ -51,7 +63,9 @@ public:
 
   QProgressBar * progressBar() const;
   QTextEdit * log() const;
+  CUiUpdateScheduler * uiScheduler() const;
   QTableView * view() const;
+  CCoverGrid * coverGrid() const;
   CLibrary * library() const;
   CSongbook * songbook() const;
   const QString workingPath();
@@ -77,6 +91,7 @@ private slots:
   //songbook
   void newSongbook();
   void open();
+  void open(const QString & filename);
   void save(bool forced=false);
   void saveAs();
   void build();
@@ -90,17 +105,33 @@ private slots:
 
   void songEditor(const QString &filename, const QString &title = QString());
   void deleteSong(const QString &filename);
+  void lyricsSearch();
+  void debugPanel();
+  void setTracing(bool value);
+  void exportTrace();
+  void openSongAtLine(const QString &filename, int line);
 
   //model
   void selectAll();
   void unselectAll();
   void invertSelection();
-  void selectLanguage(bool);
+  void selectMatching();
+  void selectSongs(const CBitSet & songs, bool selection);
+  void updateLanguageMenu();
+  void selectLanguage(QAction *action);
+  void refineFilter(const QString & term);
   void updateSongsList();
   void connectDb();
   void filterChanged();
+  void applyFilter();
   void selectionChanged();
   void selectionChanged(const QItemSelection &selected , const QItemSelection & deselected );
+  void dropHiddenCovers();
+  void dropHiddenPreviews();
+  void setCoverGridDisplayed(bool);
+  void setLargeTable(bool);
+  void adjustColumns();
+  void showPreview(const QString & cover, const QImage & image);
 
   //application
   void preferences();
@@ -113,6 +144,8 @@ private slots:
 
 private:
   void readSettings();
+  QString previewCover(int row) const;
+  void prefetchPreview(const QString & cover);
   void writeSettings();
 
   void createActions();
@@ -122,16 +155,28 @@ private:
   QGridLayout * songbookInfo();
 
   QStringList getSelectedSongs();
+  void selectMatching(const CSongQuery & query, bool selection = true);
 
   bool isToolbarDisplayed();
   bool isStatusbarDisplayed();
 
+  /// Fetches the rows of the library not fetched yet, so that the
+  /// view shows every song matching the filter.
+  void fetchAllRows();
   QItemSelectionModel * selectionModel();
   QDataWidgetMapper* m_mapper;
 
   // Song library and view
   CLibrary *m_library;
-  QSortFilterProxyModel *m_proxyModel;
+  CSongSortFilterProxyModel *m_proxyModel;
+  CSelectionModel *m_selectionModel;
+  CFilterLineEdit *m_filterLineEdit;
+  CSongQuery m_query;
+  CFacetPanel *m_facets;
+  CLyricsSearch *m_lyricsSearch;
+  CWatchdog *m_watchdog;
+  CDebugPanel *m_debugPanel;
+  int m_stallThreshold;
 
   // Songbook widget
   CSongbook *m_songbook;
@@ -145,6 +190,8 @@ private:
   // Widgets
   CTabWidget* m_mainWidget;
   QTableView *m_view;
+  CCoverGrid *m_coverGrid;
+  QStackedWidget *m_libraryViews;
   QProgressBar* m_progressBar;
   QTextEdit* m_noDataInfo;
 
@@ -162,19 +209,27 @@ private:
 
   bool m_isToolbarDisplayed;
   bool m_isStatusbarDisplayed;
+  bool m_largeTable;
   bool m_first;
 
-  QPixmap *m_cover;
+  // previews of the current song and of its neighbours
+  QCache<QString, QPixmap> m_previews;
+  QString m_currentCover;
+  QSet<QString> m_wantedPreviews;
+  QPixmap m_missingCover;
+  QPixmap m_pendingCover;
   QLabel m_coverLabel;
   CDialogNewSong *m_newSongDialog;
   CBuildEngine* m_builder;
 
   //Logs
   QTextEdit* m_log;
+  CUiUpdateScheduler *m_uiScheduler;
 
   // Menus
   QMenu *m_fileMenu;
   QMenu *m_editMenu;
+  QMenu *m_languageMenu;
   QMenu *m_dbMenu;
   QMenu *m_viewMenu;
   QMenu *m_helpMenu;
@@ -187,6 +242,8 @@ private:
   QAction *m_toolbarViewAct;
   QAction *m_statusbarViewAct;
   QAction *m_adjustColumnsAct;
+  QAction *m_coverGridAct;
+  QAction *m_largeTableAct;
   QAction *m_documentationAct;
   QAction *m_aboutAct;
   QAction *m_exitAct;
@@ -204,9 +261,7 @@ private:
   QAction *m_selectAllAct;
   QAction *m_unselectAllAct;
   QAction *m_invertSelectionAct;
-  QAction *m_selectEnglishAct;
-  QAction *m_selectFrenchAct;
-  QAction *m_selectSpanishAct;
+  QAction *m_selectMatchingAct;
   QAction *m_downloadDbAct;
   QAction *m_refreshLibraryAct;
   QAction *m_rebuildLibraryAct;
@@ -214,6 +269,10 @@ private:
   // Tools actions
   QAction *m_resizeCoversAct;
   QAction *m_checkerAct;
+  QAction *m_lyricsSearchAct;
+  QAction *m_debugPanelAct;
+  QAction *m_traceAct;
+  QAction *m_exportTraceAct;
 
   // Editors
   QMap< QString, CSongEditor* > m_editors;
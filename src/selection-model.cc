@@ -0,0 +1,268 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "selection-model.hh"
+
+#include "library.hh"
+#include "songSortFilterProxyModel.hh"
+
+//------------------------------------------------------------------------------
+CSelectionModel::CSelectionModel(CSongSortFilterProxyModel *AModel,
+				 CLibrary *ALibrary)
+  : QItemSelectionModel(AModel)
+  , m_proxyModel(AModel)
+  , m_library(ALibrary)
+  , m_songs()
+  , m_syncing(false)
+  , m_extendedFirst(-1)
+  , m_extendedLast(-1)
+{
+  // rows shown again by the filter or fetched from the database
+  connect(m_proxyModel, SIGNAL(rowsInserted(const QModelIndex &, int, int)),
+	  this, SLOT(syncInsertedRows(const QModelIndex &, int, int)));
+  connect(m_proxyModel, SIGNAL(layoutChanged()), this, SLOT(syncRows()));
+
+  connect(m_library, SIGNAL(songRemoved(int)), this, SLOT(removeSong(int)));
+  connect(m_library, SIGNAL(songsCleared()), this, SLOT(clearSongs()));
+}
+//------------------------------------------------------------------------------
+CSelectionModel::~CSelectionModel()
+{}
+//------------------------------------------------------------------------------
+const CBitSet & CSelectionModel::selectedSongs() const
+{
+  return m_songs;
+}
+//------------------------------------------------------------------------------
+int CSelectionModel::selectedCount() const
+{
+  return m_songs.count();
+}
+//------------------------------------------------------------------------------
+int CSelectionModel::songIdAt(int row) const
+{
+  return m_library->songIdAt(m_proxyModel->mapToSource(m_proxyModel->index(row, 0)).row());
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::resizeSongs()
+{
+  int size = m_library->songIds().size();
+  if (m_songs.size() < size)
+    m_songs.resize(size);
+}
+//------------------------------------------------------------------------------
+CBitSet CSelectionModel::visibleSongs() const
+{
+  CBitSet songs(m_library->songIds().size());
+  int rows = m_proxyModel->rowCount();
+  for (int row = 0; row < rows; ++row)
+    {
+      int id = songIdAt(row);
+      if (id >= 0)
+	songs.setBit(id);
+    }
+  return songs;
+}
+//------------------------------------------------------------------------------
+QItemSelection CSelectionModel::selectedRanges(int first, int last) const
+{
+  QItemSelection ranges;
+  int start = -1;
+  for (int row = first; row <= last + 1; ++row)
+    {
+      bool selected = row <= last && m_songs.testBit(songIdAt(row));
+      if (selected && start < 0)
+	{
+	  start = row;
+	}
+      else if (!selected && start >= 0)
+	{
+	  ranges.select(m_proxyModel->index(start, 0), m_proxyModel->index(row - 1, 0));
+	  start = -1;
+	}
+    }
+  return ranges;
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::select(const QItemSelection & selection,
+			     QItemSelectionModel::SelectionFlags command)
+{
+  QItemSelectionModel::select(selection, command);
+  if (m_syncing)
+    return;
+
+  resizeSongs();
+  if (command & QItemSelectionModel::Current)
+    {
+      // a selection being extended with the mouse replaces the previous
+      // one: only the rows between the anchor and the previous or the
+      // new end of the drag may have changed, unless the other rows
+      // were cleared
+      int first = m_extendedFirst;
+      int last = m_extendedLast;
+      m_extendedFirst = -1;
+      m_extendedLast = -1;
+      foreach (const QItemSelectionRange & range, selection)
+	{
+	  if (m_extendedFirst < 0 || range.top() < m_extendedFirst)
+	    m_extendedFirst = range.top();
+	  m_extendedLast = qMax(m_extendedLast, range.bottom());
+	}
+
+      if (command & QItemSelectionModel::Clear)
+	{
+	  m_songs.subtract(visibleSongs());
+	  first = 0;
+	  last = m_proxyModel->rowCount() - 1;
+	}
+      else
+	{
+	  if (first < 0 || (m_extendedFirst >= 0 && m_extendedFirst < first))
+	    first = m_extendedFirst;
+	  last = qMax(last, m_extendedLast);
+	  for (int row = first; first >= 0 && row <= last; ++row)
+	    {
+	      int id = songIdAt(row);
+	      if (id >= 0)
+		m_songs.clearBit(id);
+	    }
+	}
+
+      if (first >= 0)
+	foreach (const QItemSelectionRange & range, QItemSelectionModel::selection())
+	  for (int row = qMax(range.top(), first); row <= qMin(range.bottom(), last); ++row)
+	    {
+	      int id = songIdAt(row);
+	      if (id >= 0)
+		m_songs.setBit(id);
+	    }
+    }
+  else
+    {
+      m_extendedFirst = -1;
+      m_extendedLast = -1;
+      if (command & QItemSelectionModel::Clear)
+	m_songs.fill(false);
+
+      foreach (const QItemSelectionRange & range, selection)
+	for (int row = range.top(); row <= range.bottom(); ++row)
+	  {
+	    int id = songIdAt(row);
+	    if (id < 0)
+	      continue;
+
+	    if (command & QItemSelectionModel::Toggle)
+	      m_songs.setBit(id, !m_songs.testBit(id));
+	    else if (command & QItemSelectionModel::Select)
+	      m_songs.setBit(id);
+	    else if (command & QItemSelectionModel::Deselect)
+	      m_songs.clearBit(id);
+	  }
+    }
+  emit(selectedSongsChanged());
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::reset()
+{
+  // the model was reset but the songs remain selected
+  m_syncing = true;
+  QItemSelectionModel::reset();
+  m_syncing = false;
+  syncRows();
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::syncRows()
+{
+  // the rows may have moved
+  m_extendedFirst = -1;
+  m_extendedLast = -1;
+  m_syncing = true;
+  QItemSelectionModel::select(selectedRanges(0, m_proxyModel->rowCount() - 1),
+			      QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+  m_syncing = false;
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::syncInsertedRows(const QModelIndex & parent, int first, int last)
+{
+  if (parent.isValid() || m_songs.isEmpty())
+    return;
+
+  m_syncing = true;
+  QItemSelectionModel::select(selectedRanges(first, last),
+			      QItemSelectionModel::Select | QItemSelectionModel::Rows);
+  m_syncing = false;
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::setSelectedSongs(const CBitSet & songs)
+{
+  m_songs = songs;
+  resizeSongs();
+  syncRows();
+  emit(selectedSongsChanged());
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::selectSongs(const CBitSet & songs, bool selection)
+{
+  if (selection)
+    m_songs |= songs;
+  else
+    m_songs.subtract(songs);
+  resizeSongs();
+  syncRows();
+  emit(selectedSongsChanged());
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::selectVisibleSongs()
+{
+  m_songs |= visibleSongs();
+
+  // every row is selected: a single range
+  int rows = m_proxyModel->rowCount();
+  m_syncing = true;
+  if (rows > 0)
+    QItemSelectionModel::select(QItemSelection(m_proxyModel->index(0, 0),
+					       m_proxyModel->index(rows - 1, 0)),
+				QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+  m_syncing = false;
+  emit(selectedSongsChanged());
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::invertVisibleSongs()
+{
+  resizeSongs();
+  m_songs ^= visibleSongs();
+  syncRows();
+  emit(selectedSongsChanged());
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::clearSongs()
+{
+  m_songs = CBitSet(m_library->songIds().size());
+  m_syncing = true;
+  QItemSelectionModel::select(QItemSelection(), QItemSelectionModel::Clear);
+  m_syncing = false;
+  emit(selectedSongsChanged());
+}
+//------------------------------------------------------------------------------
+void CSelectionModel::removeSong(int id)
+{
+  if (!m_songs.testBit(id))
+    return;
+
+  m_songs.clearBit(id);
+  emit(selectedSongsChanged());
+}
@@ -0,0 +1,92 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file selection-model.hh
+ *
+ * Selection of songs of the library.
+ *
+ * The selected songs are a bitmap of song ids. The row ranges of
+ * QItemSelectionModel only mirror it for the rows currently shown,
+ * so that songs hidden by the filter remain selected.
+ *
+ */
+#ifndef __SELECTION_MODEL_HH__
+#define __SELECTION_MODEL_HH__
+
+#include <QItemSelectionModel>
+
+#include "utils/bitset.hh"
+
+class CLibrary;
+class CSongSortFilterProxyModel;
+
+/** \class CSelectionModel "selection-model.hh"
+ * \brief CSelectionModel keeps the selected song ids of a view
+ */
+class CSelectionModel : public QItemSelectionModel
+{
+  Q_OBJECT
+
+public:
+  CSelectionModel(CSongSortFilterProxyModel *model, CLibrary *library);
+  ~CSelectionModel();
+
+  /// Selected song ids, including the songs hidden by the filter.
+  const CBitSet & selectedSongs() const;
+  /// Number of selected songs, in constant time.
+  int selectedCount() const;
+
+  void setSelectedSongs(const CBitSet & songs);
+  void selectSongs(const CBitSet & songs, bool selection);
+  void selectVisibleSongs();
+  void invertVisibleSongs();
+
+  using QItemSelectionModel::select;
+  virtual void select(const QItemSelection & selection,
+		      QItemSelectionModel::SelectionFlags command);
+
+public slots:
+  virtual void reset();
+  void clearSongs();
+
+signals:
+  void selectedSongsChanged();
+
+private slots:
+  void syncRows();
+  void syncInsertedRows(const QModelIndex & parent, int first, int last);
+  void removeSong(int id);
+
+private:
+  int songIdAt(int row) const;
+  CBitSet visibleSongs() const;
+  QItemSelection selectedRanges(int first, int last) const;
+  void resizeSongs();
+
+  CSongSortFilterProxyModel *m_proxyModel;
+  CLibrary *m_library;
+  CBitSet m_songs;
+  bool m_syncing;
+
+  // rows of the selection being extended with the mouse
+  int m_extendedFirst;
+  int m_extendedLast;
+};
+
+#endif // __SELECTION_MODEL_HH__
@@ -0,0 +1,217 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "song-completer.hh"
+
+#include <QStringListModel>
+#include <QSet>
+
+#include "library.hh"
+#include "song-query.hh"
+
+namespace
+{
+  const int maxCompletions = 50;
+
+  bool caseInsensitiveLessThan(const QString & s1, const QString & s2)
+  {
+    return s1.toLower() < s2.toLower();
+  }
+}
+
+//------------------------------------------------------------------------------
+CCompletionService::CCompletionService(CLibrary *ALibrary)
+  : QObject(ALibrary)
+  , m_library(ALibrary)
+  , m_artists()
+  , m_titles()
+  , m_albums()
+{
+  connect(m_library, SIGNAL(songAdded(int)), this, SLOT(addSong(int)));
+  connect(m_library, SIGNAL(songRemoved(int)), this, SLOT(removeSong(int)));
+  connect(m_library, SIGNAL(songsCleared()), this, SLOT(reset()));
+  reset();
+}
+//------------------------------------------------------------------------------
+CCompletionService::~CCompletionService()
+{}
+//------------------------------------------------------------------------------
+void CCompletionService::reset()
+{
+  m_artists.clear();
+  m_titles.clear();
+  m_albums.clear();
+
+  const CBitSet & songs = m_library->songIds();
+  for (int id = songs.nextSetBit(0); id >= 0; id = songs.nextSetBit(id + 1))
+    addSong(id);
+}
+//------------------------------------------------------------------------------
+void CCompletionService::addSong(int id)
+{
+  const CSong & song = m_library->song(id);
+  m_artists.insert(song.artist);
+  m_titles.insert(song.title);
+  m_albums.insert(song.album);
+}
+//------------------------------------------------------------------------------
+void CCompletionService::removeSong(int id)
+{
+  const CSong & song = m_library->song(id);
+  m_artists.remove(song.artist);
+  m_titles.remove(song.title);
+  m_albums.remove(song.album);
+}
+//------------------------------------------------------------------------------
+QStringList CCompletionService::complete(const QString & prefix, int sources,
+					 int limit) const
+{
+  if (sources == Artists)
+    return m_artists.complete(prefix, limit);
+  if (sources == Titles)
+    return m_titles.complete(prefix, limit);
+  if (sources == Albums)
+    return m_albums.complete(prefix, limit);
+
+  // merge the sources, an album named after its artist is proposed once
+  QStringList values;
+  if (sources & Artists)
+    values << m_artists.complete(prefix, limit);
+  if (sources & Titles)
+    values << m_titles.complete(prefix, limit);
+  if (sources & Albums)
+    values << m_albums.complete(prefix, limit);
+
+  QStringList result;
+  QSet<QString> keys;
+  qSort(values.begin(), values.end(), caseInsensitiveLessThan);
+  foreach (const QString & value, values)
+    {
+      QString key = value.toLower();
+      if (keys.contains(key))
+	continue;
+      keys.insert(key);
+      result << value;
+      if (limit >= 0 && result.size() >= limit)
+	break;
+    }
+  return result;
+}
+//------------------------------------------------------------------------------
+CSongCompleter::CSongCompleter(CCompletionService *AService, int ASources,
+			       QObject *parent)
+  : QCompleter(parent)
+  , m_service(AService)
+  , m_model(new QStringListModel(this))
+  , m_sources(ASources)
+  , m_queryMode(false)
+  , m_head()
+{
+  setModel(m_model);
+  setCaseSensitivity(Qt::CaseInsensitive);
+}
+//------------------------------------------------------------------------------
+CSongCompleter::~CSongCompleter()
+{}
+//------------------------------------------------------------------------------
+bool CSongCompleter::queryMode() const
+{
+  return m_queryMode;
+}
+//------------------------------------------------------------------------------
+void CSongCompleter::setQueryMode(bool value)
+{
+  m_queryMode = value;
+}
+//------------------------------------------------------------------------------
+QStringList CSongCompleter::splitPath(const QString & path) const
+{
+  QString prefix = path;
+  int sources = m_sources;
+  m_head.clear();
+
+  if (m_queryMode)
+    {
+      // find the beginning of the last term, ignoring quoted spaces
+      int start = 0;
+      bool quoted = false;
+      for (int i = 0; i < path.size(); ++i)
+	{
+	  if (quoted && path[i] == '\\')
+	    ++i;
+	  else if (path[i] == '"')
+	    quoted = !quoted;
+	  else if (!quoted && path[i].isSpace())
+	    start = i + 1;
+	}
+
+      int i = start;
+      if (i < path.size() && path[i] == '-')
+	++i;
+
+      int colon = path.indexOf(':', i);
+      if (colon > i && colon < path.size())
+	{
+	  switch (CSongQuery::fieldFromName(path.mid(i, colon - i)))
+	    {
+	    case CQueryNode::Artist:
+	      sources = CCompletionService::Artists;
+	      i = colon + 1;
+	      break;
+	    case CQueryNode::Title:
+	      sources = CCompletionService::Titles;
+	      i = colon + 1;
+	      break;
+	    case CQueryNode::Album:
+	      sources = CCompletionService::Albums;
+	      i = colon + 1;
+	      break;
+	    case CQueryNode::AnyField:
+	      break;
+	    default:
+	      // values of the other fields are not completed
+	      sources = 0;
+	      break;
+	    }
+	  if (i == colon + 1 && i < path.size() && path[i] == '=')
+	    ++i;
+	}
+      m_head = path.left(i);
+
+      if (i < path.size() && path[i] == '"')
+	++i;
+      prefix = path.mid(i);
+    }
+
+  QStringList values;
+  if (sources && !prefix.isEmpty())
+    values = m_service->complete(prefix, sources, maxCompletions);
+  m_model->setStringList(values);
+
+  return QStringList(prefix);
+}
+//------------------------------------------------------------------------------
+QString CSongCompleter::pathFromIndex(const QModelIndex & index) const
+{
+  QString value = index.data(Qt::EditRole).toString();
+  if (!m_queryMode)
+    return value;
+
+  if (value.contains(' ') || value.contains('"'))
+    value = CSongQuery::quote(value);
+  return m_head + value;
+}
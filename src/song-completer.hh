@@ -0,0 +1,103 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file song-completer.hh
+ *
+ * Completion of artists, titles and albums of the library.
+ *
+ * The distinct values are kept in prefix trees updated as songs are
+ * added to and removed from the library, so that completing never
+ * goes through the library model.
+ *
+ */
+#ifndef __SONG_COMPLETER_HH__
+#define __SONG_COMPLETER_HH__
+
+#include <QObject>
+#include <QCompleter>
+
+#include "utils/prefix-trie.hh"
+
+class CLibrary;
+class QStringListModel;
+
+/** \class CCompletionService "song-completer.hh"
+ * \brief CCompletionService provides the values of the library starting with a prefix
+ */
+class CCompletionService : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum Source
+    {
+      Artists = 0x1,
+      Titles = 0x2,
+      Albums = 0x4,
+      AllSources = Artists | Titles | Albums
+    };
+
+  CCompletionService(CLibrary *library);
+  ~CCompletionService();
+
+  /// Returns at most \a limit values of \a sources starting with \a prefix.
+  QStringList complete(const QString & prefix, int sources, int limit) const;
+
+private slots:
+  void addSong(int id);
+  void removeSong(int id);
+  void reset();
+
+private:
+  CLibrary *m_library;
+  CPrefixTrie m_artists;
+  CPrefixTrie m_titles;
+  CPrefixTrie m_albums;
+};
+
+/** \class CSongCompleter "song-completer.hh"
+ * \brief CSongCompleter is a QCompleter fed by a CCompletionService
+ *
+ * In query mode, only the last term of the text is completed and a
+ * field name such as "artist:" restricts the values proposed.
+ */
+class CSongCompleter : public QCompleter
+{
+  Q_OBJECT
+
+public:
+  CSongCompleter(CCompletionService *service, int sources,
+		 QObject *parent = 0);
+  ~CSongCompleter();
+
+  bool queryMode() const;
+  void setQueryMode(bool value);
+
+  virtual QStringList splitPath(const QString & path) const;
+  virtual QString pathFromIndex(const QModelIndex & index) const;
+
+private:
+  CCompletionService *m_service;
+  QStringListModel *m_model;
+  int m_sources;
+  bool m_queryMode;
+  mutable QString m_head;
+};
+
+#endif // __SONG_COMPLETER_HH__
@@ -23,6 +23,7 @@
 #include <QToolBar>
 #include <QAction>
 #include <QTextDocumentFragment>
+#include <QTextBlock>
 #include <QFile>
 #include <QTextStream>
 
@@ -130,6 +131,18 @@ void CSongEditor::setPath(const QString &path)
   m_path = path;
 }
 //------------------------------------------------------------------------------
+void CSongEditor::goToLine(int line)
+{
+  QTextBlock block = document()->findBlockByNumber(line - 1);
+  if (!block.isValid())
+    return;
+
+  QTextCursor cursor(block);
+  setTextCursor(cursor);
+  centerCursor();
+  setFocus();
+}
+//------------------------------------------------------------------------------
 void CSongEditor::save()
 {
   //open file in write mode
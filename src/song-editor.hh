@@ -33,6 +33,9 @@ public:
   QString path();
   void setPath(const QString & APath);
 
+  /// Moves the cursor to the beginning of \a line, starting from 1.
+  void goToLine(int line);
+
   QToolBar* toolbar();
 
 signals:
@@ -0,0 +1,294 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "song-query.hh"
+
+#include <QStringList>
+
+namespace
+{
+  // Escapes LIKE wildcards so that user input is matched literally.
+  QString likePattern(const QString & value)
+  {
+    QString str(value);
+    str.replace(QString("\\"), QString("\\\\"));
+    str.replace(QString("%"), QString("\\%"));
+    str.replace(QString("_"), QString("\\_"));
+    return QString("%%1%").arg(str);
+  }
+
+  bool isTrue(const QString & value)
+  {
+    static const QStringList yes = QStringList()
+      << "yes" << "true" << "on" << "1";
+    return yes.contains(value.toLower());
+  }
+}
+
+//------------------------------------------------------------------------------
+CQueryNode::CQueryNode(Type ANodeType)
+  : type(ANodeType)
+  , field(AnyField)
+  , exact(false)
+  , value()
+  , children()
+{}
+//------------------------------------------------------------------------------
+CQueryNode::~CQueryNode()
+{
+  qDeleteAll(children);
+}
+//------------------------------------------------------------------------------
+CSongQuery::CSongQuery(const QString & AText)
+  : m_text(AText)
+  , m_root(parse(AText))
+{}
+//------------------------------------------------------------------------------
+CSongQuery::~CSongQuery()
+{}
+//------------------------------------------------------------------------------
+QString CSongQuery::text() const
+{
+  return m_text;
+}
+//------------------------------------------------------------------------------
+bool CSongQuery::isEmpty() const
+{
+  return m_root.isNull();
+}
+//------------------------------------------------------------------------------
+const CQueryNode * CSongQuery::root() const
+{
+  return m_root.data();
+}
+//------------------------------------------------------------------------------
+CQueryNode::Field CSongQuery::fieldFromName(const QString & AName)
+{
+  QString name = AName.toLower();
+  if (name == "artist")
+    return CQueryNode::Artist;
+  if (name == "title")
+    return CQueryNode::Title;
+  if (name == "album")
+    return CQueryNode::Album;
+  if (name == "lang" || name == "language")
+    return CQueryNode::Language;
+  if (name == "lilypond")
+    return CQueryNode::Lilypond;
+  if (name == "cover")
+    return CQueryNode::Cover;
+  if (name == "path")
+    return CQueryNode::Path;
+  return CQueryNode::AnyField;
+}
+//------------------------------------------------------------------------------
+QString CSongQuery::quote(const QString & AValue)
+{
+  QString value(AValue);
+  value.replace(QString("\\"), QString("\\\\"));
+  value.replace(QString("\""), QString("\\\""));
+  return QString("\"%1\"").arg(value);
+}
+//------------------------------------------------------------------------------
+CQueryNode * CSongQuery::parse(const QString & text) const
+{
+  CQueryNode *alternatives = new CQueryNode(CQueryNode::Or);
+  CQueryNode *terms = new CQueryNode(CQueryNode::And);
+
+  const int size = text.size();
+  int i = 0;
+  while (i < size)
+    {
+      if (text[i].isSpace())
+	{
+	  ++i;
+	  continue;
+	}
+
+      bool negated = false;
+      if (text[i] == '-' && i + 1 < size && !text[i+1].isSpace())
+	{
+	  negated = true;
+	  ++i;
+	}
+
+      // an unknown field name is kept as part of the value
+      CQueryNode::Field field = CQueryNode::AnyField;
+      bool exact = false;
+      int colon = i;
+      while (colon < size && text[colon].isLetter())
+	++colon;
+      if (colon > i && colon < size && text[colon] == ':')
+	{
+	  field = fieldFromName(text.mid(i, colon - i));
+	  if (field != CQueryNode::AnyField)
+	    {
+	      i = colon + 1;
+	      exact = i < size && text[i] == '=';
+	      if (exact)
+		++i;
+	    }
+	}
+
+      QString value;
+      bool quoted = false;
+      if (i < size && text[i] == '"')
+	{
+	  for (++i; i < size && text[i] != '"'; ++i)
+	    {
+	      if (text[i] == '\\' && i + 1 < size)
+		++i;
+	      value += text[i];
+	    }
+	  ++i;
+	  quoted = true;
+	}
+      else
+	{
+	  int end = i;
+	  while (end < size && !text[end].isSpace())
+	    ++end;
+	  value = text.mid(i, end - i);
+	  i = end;
+	}
+
+      if (!quoted && !negated && field == CQueryNode::AnyField && value == "OR")
+	{
+	  if (!terms->children.isEmpty())
+	    {
+	      alternatives->children << terms;
+	      terms = new CQueryNode(CQueryNode::And);
+	    }
+	  continue;
+	}
+
+      // ignore incomplete terms such as "artist:" while typing
+      if (value.isEmpty())
+	continue;
+
+      CQueryNode *term = new CQueryNode(CQueryNode::Term);
+      term->field = field;
+      term->exact = exact;
+      term->value = value;
+      if (negated)
+	{
+	  CQueryNode *node = new CQueryNode(CQueryNode::Not);
+	  node->children << term;
+	  term = node;
+	}
+      terms->children << term;
+    }
+
+  if (!terms->children.isEmpty())
+    alternatives->children << terms;
+  else
+    delete terms;
+
+  // collapse single child nodes
+  CQueryNode *root = alternatives;
+  while ((root->type == CQueryNode::Or || root->type == CQueryNode::And)
+	 && root->children.size() == 1)
+    {
+      CQueryNode *child = root->children.takeFirst();
+      delete root;
+      root = child;
+    }
+
+  if (root->children.isEmpty() && root->type != CQueryNode::Term)
+    {
+      delete root;
+      return 0;
+    }
+  return root;
+}
+//------------------------------------------------------------------------------
+QString CSongQuery::toSql(QVariantList & bindings) const
+{
+  if (isEmpty())
+    return QString("1");
+
+  return compile(root(), bindings);
+}
+//------------------------------------------------------------------------------
+QString CSongQuery::compile(const CQueryNode * node, QVariantList & bindings) const
+{
+  switch (node->type)
+    {
+    case CQueryNode::Not:
+      return QString("NOT (%1)").arg(compile(node->children.first(), bindings));
+
+    case CQueryNode::And:
+    case CQueryNode::Or:
+      {
+	QStringList conditions;
+	foreach (const CQueryNode *child, node->children)
+	  conditions << QString("(%1)").arg(compile(child, bindings));
+	return conditions.join(node->type == CQueryNode::And ? " AND " : " OR ");
+      }
+
+    case CQueryNode::Term:
+      break;
+    }
+
+  const char *column = 0;
+  switch (node->field)
+    {
+    case CQueryNode::Artist:
+      column = "artist";
+      break;
+    case CQueryNode::Title:
+      column = "title";
+      break;
+    case CQueryNode::Album:
+      column = "album";
+      break;
+    case CQueryNode::Path:
+      column = "path";
+      break;
+    case CQueryNode::Language:
+      bindings << node->value;
+      return QString("lang = ? COLLATE NOCASE");
+    case CQueryNode::Lilypond:
+      bindings << (isTrue(node->value) ? 1 : 0);
+      return QString("lilypond = ?");
+    case CQueryNode::Cover:
+      bindings << (isTrue(node->value) ? 1 : 0);
+      return QString("has_cover = ?");
+    case CQueryNode::AnyField:
+      break;
+    }
+
+  // exact terms use the indexes of the columns, which ignore the case
+  // like the LIKE operator; paths are compared as they are
+  if (column && node->exact)
+    {
+      bindings << node->value;
+      if (node->field == CQueryNode::Path)
+	return QString("path = ?");
+      return QString("%1 = ? COLLATE NOCASE").arg(column);
+    }
+  if (column)
+    {
+      bindings << likePattern(node->value);
+      return QString("%1 LIKE ? ESCAPE '\\'").arg(column);
+    }
+
+  QString pattern = likePattern(node->value);
+  bindings << pattern << pattern << pattern;
+  return QString("artist LIKE ? ESCAPE '\\' OR title LIKE ? ESCAPE '\\' "
+		 "OR album LIKE ? ESCAPE '\\'");
+}
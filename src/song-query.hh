@@ -0,0 +1,102 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file song-query.hh
+ *
+ * Query language for the song library.
+ *
+ * A query is a list of terms that must all match. A term is either a
+ * bare word, matched against artist, title and album, or a
+ * field-qualified word such as:
+ *
+ *   artist:brel lang:french lilypond:yes cover:no album:"Ne me quitte pas"
+ *
+ * A field name followed by '=', as in artist:="Jacques Brel", matches
+ * the whole value instead of a part of it. In a quoted value, '\"'
+ * and '\\' stand for a quote and a backslash.
+ *
+ * A term prefixed with '-' is negated and the OR keyword separates
+ * alternatives. The query is parsed once into an AST which is then
+ * compiled into a parameterized SQL condition on the songs table.
+ *
+ * Exact terms and languages are compared without case and served by
+ * the indexes of the songs table; the other terms match a part of the
+ * value with LIKE and scan the table.
+ *
+ */
+#ifndef __SONG_QUERY_HH__
+#define __SONG_QUERY_HH__
+
+#include <QString>
+#include <QList>
+#include <QVariant>
+#include <QSharedPointer>
+
+/** \class CQueryNode "song-query.hh"
+ * \brief CQueryNode is a node of the AST built by CSongQuery
+ */
+class CQueryNode
+{
+public:
+  enum Type { Term, Not, And, Or };
+  enum Field { AnyField, Artist, Title, Album, Language, Lilypond, Cover, Path };
+
+  CQueryNode(Type type);
+  ~CQueryNode();
+
+  Type type;
+  Field field;
+  bool exact;
+  QString value;
+  QList< CQueryNode* > children;
+};
+
+/** \class CSongQuery "song-query.hh"
+ * \brief CSongQuery parses a filter string and compiles it to SQL
+ */
+class CSongQuery
+{
+public:
+  CSongQuery(const QString & text = QString());
+  ~CSongQuery();
+
+  QString text() const;
+  bool isEmpty() const;
+
+  const CQueryNode * root() const;
+
+  /// Returns the SQL condition matching this query and appends the
+  /// values to bind, in order, to \a bindings.
+  QString toSql(QVariantList & bindings) const;
+
+  static CQueryNode::Field fieldFromName(const QString & name);
+
+  /// Returns \a value quoted so that it is parsed back as a single
+  /// value, whatever its spaces and quotes.
+  static QString quote(const QString & value);
+
+private:
+  CQueryNode * parse(const QString & text) const;
+  QString compile(const CQueryNode * node, QVariantList & bindings) const;
+
+  QString m_text;
+  QSharedPointer< CQueryNode > m_root;
+};
+
+#endif // __SONG_QUERY_HH__
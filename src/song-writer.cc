@@ -0,0 +1,54 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "song-writer.hh"
+
+#include <QSqlError>
+#include <QVariant>
+
+#include "library.hh"
+
+//------------------------------------------------------------------------------
+CSongWriter::CSongWriter(QSqlDatabase ADatabase)
+  : m_query(ADatabase)
+{
+  m_query.prepare("INSERT INTO songs (artist, title, lilypond, path, album, "
+		  "cover, lang, cover_path, has_cover) "
+		  "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+}
+//------------------------------------------------------------------------------
+CSongWriter::~CSongWriter()
+{}
+//------------------------------------------------------------------------------
+bool CSongWriter::insert(const CSong & song)
+{
+  m_query.bindValue(0, song.artist);
+  m_query.bindValue(1, song.title);
+  m_query.bindValue(2, song.lilypond);
+  m_query.bindValue(3, song.path);
+  m_query.bindValue(4, song.album);
+  m_query.bindValue(5, song.cover);
+  m_query.bindValue(6, song.lang);
+  m_query.bindValue(7, song.coverPath);
+  m_query.bindValue(8, song.hasCover);
+  return m_query.exec();
+}
+//------------------------------------------------------------------------------
+QString CSongWriter::lastError() const
+{
+  return m_query.lastError().text();
+}
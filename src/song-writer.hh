@@ -0,0 +1,53 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file song-writer.hh
+ *
+ * Insertion of songs in the songs table.
+ *
+ * The statement is prepared once and each song only binds its values,
+ * which share the data of the strings of the song.
+ *
+ */
+#ifndef __SONG_WRITER_HH__
+#define __SONG_WRITER_HH__
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+
+struct CSong;
+
+/** \class CSongWriter "song-writer.hh"
+ * \brief CSongWriter inserts songs with a prepared statement
+ */
+class CSongWriter
+{
+public:
+  CSongWriter(QSqlDatabase db = QSqlDatabase::database());
+  ~CSongWriter();
+
+  bool insert(const CSong & song);
+  QString lastError() const;
+
+private:
+  QSqlQuery m_query;
+};
+
+#endif // __SONG_WRITER_HH__
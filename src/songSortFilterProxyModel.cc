@@ -1,19 +1,83 @@
 #include "songSortFilterProxyModel.hh"
+#include "library.hh"
+#include "utils/utils.hh"
+#include "tracer.hh"
 
 CSongSortFilterProxyModel::CSongSortFilterProxyModel(QObject *parent)
   : QSortFilterProxyModel(parent)
+  , m_filtered(false)
+  , m_songs()
 {}
 
 CSongSortFilterProxyModel::~CSongSortFilterProxyModel()
 {}
 
+bool CSongSortFilterProxyModel::isFiltered() const
+{
+  return m_filtered;
+}
+
+void CSongSortFilterProxyModel::setSongFilter(const CBitSet & songs)
+{
+  SB_TRACE("CSongSortFilterProxyModel::setSongFilter");
+  m_filtered = true;
+  m_songs = songs;
+  invalidateFilter();
+}
+
+const CBitSet & CSongSortFilterProxyModel::songFilter() const
+{
+  return m_songs;
+}
+
+void CSongSortFilterProxyModel::clearSongFilter()
+{
+  if (!m_filtered)
+    return;
+
+  SB_TRACE("CSongSortFilterProxyModel::clearSongFilter");
+  m_filtered = false;
+  m_songs = CBitSet();
+  invalidateFilter();
+}
+
+void CSongSortFilterProxyModel::sort(int column, Qt::SortOrder order)
+{
+  SB_TRACE("CSongSortFilterProxyModel::sort");
+  QSortFilterProxyModel::sort(column, order);
+}
+
 bool CSongSortFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
-  QModelIndex index0 = sourceModel()->index(sourceRow, 0, sourceParent);
-  QModelIndex index1 = sourceModel()->index(sourceRow, 1, sourceParent);
-  QModelIndex index2 = sourceModel()->index(sourceRow, 4, sourceParent);
-  
-  return sourceModel()->data(index0).toString().contains(filterRegExp())
-    || sourceModel()->data(index1).toString().contains(filterRegExp())
-    || sourceModel()->data(index2).toString().contains(filterRegExp());
+  if (!m_filtered)
+    return true;
+
+  Q_UNUSED(sourceParent);
+  const CLibrary *library = static_cast< const CLibrary* >(sourceModel());
+  return m_songs.testBit(library->songIdAt(sourceRow));
+}
+
+bool CSongSortFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+  if (left.column() > 1)
+    return QSortFilterProxyModel::lessThan(left, right);
+
+  const CLibrary *library = static_cast< const CLibrary* >(sourceModel());
+  int id1 = library->songIdAt(left.row());
+  int id2 = library->songIdAt(right.row());
+  if (id1 < 0 || id2 < 0)
+    return QSortFilterProxyModel::lessThan(left, right);
+
+  if (left.column() == 0)
+    {
+      const QVector<int> & ranks = library->songRanks();
+      return ranks[id1] < ranks[id2];
+    }
+
+  const CSong & song1 = library->song(id1);
+  const CSong & song2 = library->song(id2);
+  int cmp = SbUtils::compareCollationKeys(song1.titleKey, song2.titleKey);
+  if (cmp == 0)
+    cmp = SbUtils::compareCollationKeys(song1.artistKey, song2.artistKey);
+  return cmp < 0;
 }
@@ -3,11 +3,18 @@
  *
  * Sort and filter proxy model for the songs library.
  *
+ * Filtering is not evaluated by the proxy itself: the filter query is
+ * run by the library against the database and the proxy only checks
+ * whether the song id of a row belongs to the result.
+ *
  */
 #ifndef __SONG_SORT_FILTER_PROXY_MODEL_HH__
 #define __SONG_SORT_FILTER_PROXY_MODEL_HH__
 
 #include <QSortFilterProxyModel>
+#include "utils/bitset.hh"
+
+class CLibrary;
 
 class CSongSortFilterProxyModel : public QSortFilterProxyModel
 {
@@ -17,8 +24,24 @@ public:
   CSongSortFilterProxyModel(QObject *parent = 0);
   ~CSongSortFilterProxyModel();
 
+  bool isFiltered() const;
+  void setSongFilter(const CBitSet & songs);
+  const CBitSet & songFilter() const;
+  void clearSongFilter();
+
+  void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
 protected:
   bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+
+  // Sorting by artist orders songs by artist then title and sorting by
+  // title orders them by title then artist, both using the collation
+  // keys computed when the songs are added to the library.
+  bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
+
+private:
+  bool m_filtered;
+  CBitSet m_songs;
 };
 
 #endif // __SONG_SORT_FILTER_PROXY_MODEL_HH__
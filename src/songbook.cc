@@ -37,6 +37,8 @@
 
 #include "qtpropertymanager.h"
 #include "mainwindow.hh"
+#include "watchdog.hh"
+#include "tracer.hh"
 #include "unit-property-manager.hh"
 #include "unit-factory.hh"
 #include "file-property-manager.hh"
@@ -190,6 +192,8 @@ void CSongbook::reset()
 
 void CSongbook::changeTemplate(const QString & filename)
 {
+  CWatchdogTag tag("changeTemplate");
+  SB_TRACE("CSongbook::changeTemplate");
   QString templateFilename("patacrep.tmpl");
   if (!filename.isEmpty())
     templateFilename = filename;
@@ -407,6 +411,7 @@ void CSongbook::changeTemplate(const QString & filename)
 
 void CSongbook::save(const QString & filename)
 {
+  SB_TRACE("CSongbook::save");
   QFile file(filename);
   if (file.open(QIODevice::WriteOnly | QIODevice::Text))
     {
@@ -524,6 +529,7 @@ void CSongbook::save(const QString & filename)
 
 void CSongbook::load(const QString & filename)
 {
+  SB_TRACE("CSongbook::load");
   QFile file(filename);
   if (file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
@@ -0,0 +1,127 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "startup-profile.hh"
+
+#include <QEvent>
+#include <QTextStream>
+#include <QWidget>
+
+//------------------------------------------------------------------------------
+CStartupProfile::CStartupProfile()
+  : QObject()
+  , m_enabled(false)
+  , m_clock()
+  , m_phases()
+  , m_firstPaint(-1)
+{}
+//------------------------------------------------------------------------------
+CStartupProfile * CStartupProfile::instance()
+{
+  static CStartupProfile profile;
+  return &profile;
+}
+//------------------------------------------------------------------------------
+void CStartupProfile::start()
+{
+  m_enabled = true;
+  m_phases.clear();
+  m_firstPaint = -1;
+  m_clock.start();
+}
+//------------------------------------------------------------------------------
+bool CStartupProfile::isEnabled() const
+{
+  return m_enabled;
+}
+//------------------------------------------------------------------------------
+void CStartupProfile::addPhase(const char *name, qint64 duration)
+{
+  m_phases << Phase(QString::fromLatin1(name), duration);
+}
+//------------------------------------------------------------------------------
+QList<CStartupProfile::Phase> CStartupProfile::phases() const
+{
+  return m_phases;
+}
+//------------------------------------------------------------------------------
+qint64 CStartupProfile::elapsed() const
+{
+  return m_clock.nsecsElapsed() / 1000;
+}
+//------------------------------------------------------------------------------
+void CStartupProfile::watchFirstPaint(QWidget *widget)
+{
+  widget->installEventFilter(this);
+}
+//------------------------------------------------------------------------------
+qint64 CStartupProfile::firstPaint() const
+{
+  return m_firstPaint;
+}
+//------------------------------------------------------------------------------
+bool CStartupProfile::eventFilter(QObject *object, QEvent *event)
+{
+  if (event->type() == QEvent::Paint && m_firstPaint < 0)
+    {
+      m_firstPaint = elapsed();
+      object->removeEventFilter(this);
+      // reported once the paint is done
+      QMetaObject::invokeMethod(this, "firstPainted", Qt::QueuedConnection);
+    }
+  return false;
+}
+//------------------------------------------------------------------------------
+void CStartupProfile::report(QTextStream & out) const
+{
+  qint64 total = 0;
+  foreach (const Phase & phase, m_phases)
+    total += phase.second;
+
+  out << "startup phases:\n";
+  foreach (const Phase & phase, m_phases)
+    out << QString("  %1 %2 ms %3%\n")
+      .arg(phase.first, -24)
+      .arg(phase.second / 1000.0, 9, 'f', 2)
+      .arg(total ? 100.0 * phase.second / total : 0.0, 5, 'f', 1);
+  out << QString("  %1 %2 ms\n").arg("total", -24).arg(total / 1000.0, 9, 'f', 2);
+  if (m_firstPaint >= 0)
+    out << QString("  %1 %2 ms\n").arg("first paint", -24)
+      .arg(m_firstPaint / 1000.0, 9, 'f', 2);
+  out.flush();
+}
+//------------------------------------------------------------------------------
+void CStartupProfile::report()
+{
+  QTextStream out(stdout);
+  report(out);
+}
+//------------------------------------------------------------------------------
+CStartupPhase::CStartupPhase(const char *AName)
+  : m_name(CStartupProfile::instance()->isEnabled() ? AName : 0)
+  , m_start(m_name ? CStartupProfile::instance()->elapsed() : 0)
+  , m_trace(AName)
+{}
+//------------------------------------------------------------------------------
+CStartupPhase::~CStartupPhase()
+{
+  if (m_name)
+    {
+      CStartupProfile *profile = CStartupProfile::instance();
+      profile->addPhase(m_name, profile->elapsed() - m_start);
+    }
+}
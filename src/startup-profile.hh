@@ -0,0 +1,111 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file startup-profile.hh
+ *
+ * Duration of the phases of the startup of the application.
+ *
+ * The phases are only timed when profiling was enabled, with the
+ * --profile-startup option or by a benchmark. The report lists the
+ * phases of the construction of the main window and the time elapsed
+ * until its first paint.
+ *
+ */
+#ifndef __STARTUP_PROFILE_HH__
+#define __STARTUP_PROFILE_HH__
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+#include "tracer.hh"
+
+class QEvent;
+class QTextStream;
+class QWidget;
+
+/** \class CStartupProfile "startup-profile.hh"
+ * \brief CStartupProfile records the phases of the startup
+ */
+class CStartupProfile : public QObject
+{
+  Q_OBJECT
+
+public:
+  typedef QPair<QString, qint64> Phase;
+
+  static CStartupProfile * instance();
+
+  /// Enables the profile, the clock starts at this call.
+  void start();
+  bool isEnabled() const;
+
+  /// Duration in microseconds of a phase, in order of completion.
+  void addPhase(const char *name, qint64 duration);
+  QList<Phase> phases() const;
+
+  /// Microseconds elapsed since start().
+  qint64 elapsed() const;
+
+  /// Records the first paint of \a widget.
+  void watchFirstPaint(QWidget *widget);
+  /// Microseconds elapsed until the first paint, or -1.
+  qint64 firstPaint() const;
+
+  void report(QTextStream & out) const;
+
+public slots:
+  /// Prints the report on the standard output.
+  void report();
+
+signals:
+  void firstPainted();
+
+protected:
+  bool eventFilter(QObject *object, QEvent *event);
+
+private:
+  CStartupProfile();
+
+  bool m_enabled;
+  QElapsedTimer m_clock;
+  QList<Phase> m_phases;
+  qint64 m_firstPaint;
+};
+
+/** \class CStartupPhase "startup-profile.hh"
+ * \brief CStartupPhase times a phase of the startup until its end
+ *
+ * The phase is also traced when the tracer is enabled.
+ */
+class CStartupPhase
+{
+public:
+  CStartupPhase(const char *name);
+  ~CStartupPhase();
+
+private:
+  const char *m_name;
+  qint64 m_start;
+  CTraceScope m_trace;
+};
+
+#endif // __STARTUP_PROFILE_HH__
@@ -0,0 +1,258 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "thumbnail-loader.hh"
+
+#include <QMetaObject>
+#include <QRunnable>
+#include <QStringList>
+
+#include "cover-cache.hh"
+#include "cover-atlas.hh"
+
+namespace
+{
+  class ThumbnailTask : public QRunnable
+  {
+  public:
+    ThumbnailTask(CThumbnailLoader *loader, const QString & cover)
+      : m_loader(loader), m_cover(cover) {}
+
+    void run()
+    {
+      if (!m_loader->take(m_cover))
+	return;
+
+      // covers already in the atlas are not decoded again
+      QByteArray key = CCoverCache::key(m_cover);
+      int generation = 0;
+      int slot = m_loader->atlas()->find(key, &generation);
+      if (slot < 0 && !key.isEmpty())
+	slot = m_loader->atlas()->insert(key, m_loader->cache()->thumbnail(m_cover, CCoverCache::Small),
+					 &generation);
+
+      QMetaObject::invokeMethod(m_loader, "finish", Qt::QueuedConnection,
+				Q_ARG(QString, m_cover), Q_ARG(int, slot),
+				Q_ARG(int, generation));
+    }
+
+  private:
+    CThumbnailLoader *m_loader;
+    QString m_cover;
+  };
+
+  class PreviewTask : public QRunnable
+  {
+  public:
+    PreviewTask(CThumbnailLoader *loader, const QString & cover)
+      : m_loader(loader), m_cover(cover) {}
+
+    void run()
+    {
+      if (!m_loader->takePreview(m_cover))
+	return;
+
+      QImage image = m_loader->cache()->thumbnail(m_cover, CCoverCache::Preview);
+      QMetaObject::invokeMethod(m_loader, "finishPreview", Qt::QueuedConnection,
+				Q_ARG(QString, m_cover), Q_ARG(QImage, image));
+    }
+
+  private:
+    CThumbnailLoader *m_loader;
+    QString m_cover;
+  };
+
+  class PrepareTask : public QRunnable
+  {
+  public:
+    PrepareTask(CThumbnailLoader *loader, const QString & cover)
+      : m_loader(loader), m_cover(cover) {}
+
+    void run()
+    {
+      if (m_loader->takePreparation(m_cover))
+	m_loader->cache()->prepare(m_cover);
+    }
+
+  private:
+    CThumbnailLoader *m_loader;
+    QString m_cover;
+  };
+
+  // below any request made by the views
+  const int PreparePriority = -1;
+}
+
+//------------------------------------------------------------------------------
+CThumbnailLoader::CThumbnailLoader(CCoverCache *ACache, CCoverAtlas *AAtlas,
+				   QObject *parent)
+  : QObject(parent)
+  , m_cache(ACache)
+  , m_atlas(AAtlas)
+  , m_pool()
+  , m_sequence(0)
+  , m_pending()
+  , m_pendingPreviews()
+  , m_mutex()
+  , m_queued()
+  , m_queuedPreviews()
+  , m_queuedPreparations()
+{}
+//------------------------------------------------------------------------------
+CThumbnailLoader::~CThumbnailLoader()
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    m_queued.clear();
+    m_queuedPreviews.clear();
+    m_queuedPreparations.clear();
+  }
+  m_pool.waitForDone();
+}
+//------------------------------------------------------------------------------
+CCoverCache * CThumbnailLoader::cache() const
+{
+  return m_cache;
+}
+//------------------------------------------------------------------------------
+CCoverAtlas * CThumbnailLoader::atlas() const
+{
+  return m_atlas;
+}
+//------------------------------------------------------------------------------
+void CThumbnailLoader::request(const QString & cover)
+{
+  if (m_pending.contains(cover))
+    return;
+
+  m_pending.insert(cover);
+  {
+    QMutexLocker locker(&m_mutex);
+    m_queued.insert(cover);
+  }
+
+  // the rows painted last are the ones on screen
+  m_pool.start(new ThumbnailTask(this, cover), ++m_sequence);
+}
+//------------------------------------------------------------------------------
+bool CThumbnailLoader::isPending(const QString & cover) const
+{
+  return m_pending.contains(cover);
+}
+//------------------------------------------------------------------------------
+void CThumbnailLoader::requestPreview(const QString & cover)
+{
+  if (m_pendingPreviews.contains(cover))
+    return;
+
+  m_pendingPreviews.insert(cover);
+  {
+    QMutexLocker locker(&m_mutex);
+    m_queuedPreviews.insert(cover);
+  }
+  m_pool.start(new PreviewTask(this, cover), ++m_sequence);
+}
+//------------------------------------------------------------------------------
+void CThumbnailLoader::prepare(const QString & cover)
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    if (m_queuedPreparations.contains(cover))
+      return;
+    m_queuedPreparations.insert(cover);
+  }
+  m_pool.start(new PrepareTask(this, cover), PreparePriority);
+}
+//------------------------------------------------------------------------------
+void CThumbnailLoader::retainOnly(const QSet<QString> & covers)
+{
+  QMutexLocker locker(&m_mutex);
+  QSet<QString>::iterator it = m_queued.begin();
+  while (it != m_queued.end())
+    {
+      if (covers.contains(*it))
+	{
+	  ++it;
+	  continue;
+	}
+
+      // the task is left in the pool and returns without decoding
+      m_pending.remove(*it);
+      it = m_queued.erase(it);
+    }
+}
+//------------------------------------------------------------------------------
+void CThumbnailLoader::retainPreviews(const QSet<QString> & covers)
+{
+  QStringList dropped;
+  {
+    QMutexLocker locker(&m_mutex);
+    QSet<QString>::iterator it = m_queuedPreviews.begin();
+    while (it != m_queuedPreviews.end())
+      {
+	if (covers.contains(*it))
+	  {
+	    ++it;
+	    continue;
+	  }
+
+	m_pendingPreviews.remove(*it);
+	dropped << *it;
+	it = m_queuedPreviews.erase(it);
+      }
+  }
+
+  foreach (const QString & cover, dropped)
+    emit(previewDropped(cover));
+}
+//------------------------------------------------------------------------------
+bool CThumbnailLoader::take(const QString & cover)
+{
+  QMutexLocker locker(&m_mutex);
+  return m_queued.remove(cover);
+}
+//------------------------------------------------------------------------------
+bool CThumbnailLoader::takePreview(const QString & cover)
+{
+  QMutexLocker locker(&m_mutex);
+  return m_queuedPreviews.remove(cover);
+}
+//------------------------------------------------------------------------------
+bool CThumbnailLoader::takePreparation(const QString & cover)
+{
+  QMutexLocker locker(&m_mutex);
+  return m_queuedPreparations.remove(cover);
+}
+//------------------------------------------------------------------------------
+void CThumbnailLoader::finish(const QString & cover, int slot, int generation)
+{
+  m_pending.remove(cover);
+
+  // the atlas was compacted since the slot was found: look it up again
+  if (slot >= 0 && generation != m_atlas->generation())
+    {
+      request(cover);
+      return;
+    }
+  emit(thumbnailReady(cover, slot));
+}
+//------------------------------------------------------------------------------
+void CThumbnailLoader::finishPreview(const QString & cover, const QImage & image)
+{
+  m_pendingPreviews.remove(cover);
+  emit(previewReady(cover, image));
+}
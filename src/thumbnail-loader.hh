@@ -0,0 +1,118 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file thumbnail-loader.hh
+ *
+ * Production of the cover thumbnails of the library outside of the
+ * interface thread.
+ *
+ * The most recent requests are decoded first since they come from the
+ * rows being painted. Requests for covers that are no longer visible
+ * may be dropped before they are decoded.
+ *
+ */
+#ifndef __THUMBNAIL_LOADER_HH__
+#define __THUMBNAIL_LOADER_HH__
+
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+
+class CCoverCache;
+class CCoverAtlas;
+
+/** \class CThumbnailLoader "thumbnail-loader.hh"
+ * \brief CThumbnailLoader fills the cover atlas on a thread pool
+ */
+class CThumbnailLoader : public QObject
+{
+  Q_OBJECT
+
+public:
+  CThumbnailLoader(CCoverCache *cache, CCoverAtlas *atlas, QObject *parent = 0);
+  ~CThumbnailLoader();
+
+  /// Queues the storage of the small thumbnail of \a cover in the atlas.
+  void request(const QString & cover);
+  bool isPending(const QString & cover) const;
+
+  /// Queues the decoding of the preview of \a cover, before any
+  /// request made until now.
+  void requestPreview(const QString & cover);
+
+  /// Queues the generation of all the thumbnails of \a cover, with
+  /// the lowest priority.
+  void prepare(const QString & cover);
+
+  /// Drops the queued requests whose cover is not in \a covers.
+  void retainOnly(const QSet<QString> & covers);
+
+  /// Drops the queued previews whose cover is not in \a covers and
+  /// emits previewDropped() for each of them.
+  void retainPreviews(const QSet<QString> & covers);
+
+  /// Returns false if the request for \a cover was dropped, called by
+  /// the threads of the pool before decoding.
+  bool take(const QString & cover);
+  bool takePreview(const QString & cover);
+
+  /// Returns false if the preparation of \a cover was dropped when
+  /// the loader was destroyed.
+  bool takePreparation(const QString & cover);
+
+  CCoverCache * cache() const;
+  CCoverAtlas * atlas() const;
+
+signals:
+  /// Emitted in the thread of the loader with the slot of \a cover in
+  /// the atlas, -1 if the cover could not be decoded.
+  void thumbnailReady(const QString & cover, int slot);
+
+  /// Emitted in the thread of the loader, \a image is null if the
+  /// cover could not be decoded.
+  void previewReady(const QString & cover, const QImage & image);
+
+  /// Emitted when the preview of \a cover is dropped before being
+  /// decoded, it has to be requested again.
+  void previewDropped(const QString & cover);
+
+private slots:
+  void finish(const QString & cover, int slot, int generation);
+  void finishPreview(const QString & cover, const QImage & image);
+
+private:
+  CCoverCache *m_cache;
+  CCoverAtlas *m_atlas;
+  QThreadPool m_pool;
+  int m_sequence;
+
+  // requests not finished yet, only used by the thread of the loader
+  QSet<QString> m_pending;
+  QSet<QString> m_pendingPreviews;
+
+  // requests not started yet
+  QMutex m_mutex;
+  QSet<QString> m_queued;
+  QSet<QString> m_queuedPreviews;
+  QSet<QString> m_queuedPreparations;
+};
+
+#endif // __THUMBNAIL_LOADER_HH__
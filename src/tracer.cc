@@ -0,0 +1,183 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "tracer.hh"
+
+#include <QFile>
+#include <QMap>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+
+QAtomicInt CTracer::s_enabled(0);
+
+namespace
+{
+  QString jsonString(const char *text)
+  {
+    QString str = QString::fromLatin1(text);
+    str.replace("\\", "\\\\");
+    str.replace("\"", "\\\"");
+    return QString("\"%1\"").arg(str);
+  }
+}
+
+//------------------------------------------------------------------------------
+CTracer::Metric::Metric()
+  : name()
+  , counter(false)
+  , count(0)
+  , total(0)
+  , maximum(0)
+  , last(0)
+{}
+//------------------------------------------------------------------------------
+CTracer::CTracer()
+  : m_mutex()
+  , m_clock()
+  , m_events(Capacity)
+  , m_next(0)
+  , m_wrapped(false)
+  , m_metrics()
+{
+  m_clock.start();
+}
+//------------------------------------------------------------------------------
+CTracer * CTracer::instance()
+{
+  static CTracer tracer;
+  return &tracer;
+}
+//------------------------------------------------------------------------------
+void CTracer::setEnabled(bool value)
+{
+  // create the clock before the first event
+  instance();
+  s_enabled = value ? 1 : 0;
+}
+//------------------------------------------------------------------------------
+qint64 CTracer::now() const
+{
+  return m_clock.nsecsElapsed() / 1000;
+}
+//------------------------------------------------------------------------------
+void CTracer::record(const char *name, qint64 start, qint64 duration)
+{
+  Event event;
+  event.name = name;
+  event.counter = false;
+  event.start = start;
+  event.value = duration;
+  event.thread = QThread::currentThreadId();
+  append(event);
+}
+//------------------------------------------------------------------------------
+void CTracer::count(const char *name, qint64 value)
+{
+  Event event;
+  event.name = name;
+  event.counter = true;
+  event.start = now();
+  event.value = value;
+  event.thread = QThread::currentThreadId();
+  append(event);
+}
+//------------------------------------------------------------------------------
+void CTracer::append(const Event & event)
+{
+  QMutexLocker locker(&m_mutex);
+  m_events[m_next] = event;
+  if (++m_next == Capacity)
+    {
+      m_next = 0;
+      m_wrapped = true;
+    }
+
+  Metric & metric = m_metrics[event.name];
+  if (metric.count == 0)
+    {
+      metric.name = QString::fromLatin1(event.name);
+      metric.counter = event.counter;
+    }
+  ++metric.count;
+  metric.total += event.value;
+  metric.maximum = qMax(metric.maximum, event.value);
+  metric.last = event.value;
+}
+//------------------------------------------------------------------------------
+QList<CTracer::Metric> CTracer::metrics() const
+{
+  QMutexLocker locker(&m_mutex);
+
+  // identical names may be distinct literals
+  QMap<QString, Metric> merged;
+  foreach (const Metric & metric, m_metrics)
+    {
+      QMap<QString, Metric>::iterator it = merged.find(metric.name);
+      if (it == merged.end())
+	{
+	  merged.insert(metric.name, metric);
+	  continue;
+	}
+      it->count += metric.count;
+      it->total += metric.total;
+      it->maximum = qMax(it->maximum, metric.maximum);
+      it->last = metric.last;
+    }
+  return merged.values();
+}
+//------------------------------------------------------------------------------
+void CTracer::clear()
+{
+  QMutexLocker locker(&m_mutex);
+  m_next = 0;
+  m_wrapped = false;
+  m_metrics.clear();
+}
+//------------------------------------------------------------------------------
+bool CTracer::exportChromeTrace(const QString & filename) const
+{
+  QFile file(filename);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    return false;
+
+  QMutexLocker locker(&m_mutex);
+  QTextStream stream(&file);
+  QHash<Qt::HANDLE, int> threads;
+
+  stream << "{\"traceEvents\":[";
+  int size = m_wrapped ? int(Capacity) : m_next;
+  int first = m_wrapped ? m_next : 0;
+  for (int i = 0; i < size; ++i)
+    {
+      const Event & event = m_events[(first + i) % Capacity];
+      QHash<Qt::HANDLE, int>::const_iterator thread = threads.constFind(event.thread);
+      if (thread == threads.constEnd())
+	thread = threads.insert(event.thread, threads.size() + 1);
+
+      stream << (i ? ",\n" : "\n")
+	     << "{\"name\":" << jsonString(event.name)
+	     << ",\"cat\":\"songbook\",\"pid\":1,\"tid\":" << thread.value()
+	     << ",\"ts\":" << event.start;
+      if (event.counter)
+	stream << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+      else
+	stream << ",\"ph\":\"X\",\"dur\":" << event.value << "}";
+    }
+  stream << "\n]}\n";
+  return stream.status() == QTextStream::Ok;
+}
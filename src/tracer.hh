@@ -0,0 +1,156 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file tracer.hh
+ *
+ * Scoped timers and counters recorded in a ring buffer.
+ *
+ * The instrumented code uses SB_TRACE and SB_TRACE_COUNT. While the
+ * tracer is disabled, both only test a flag. The events can be
+ * exported in the Chrome trace format (chrome://tracing) and are
+ * aggregated per name for the metrics panel.
+ *
+ * Names must be string literals since only their address is recorded.
+ *
+ */
+#ifndef __TRACER_HH__
+#define __TRACER_HH__
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/** \class CTracer "tracer.hh"
+ * \brief CTracer stores the last events recorded by any thread
+ */
+class CTracer
+{
+public:
+  /// Number of events kept, older events are overwritten.
+  enum { Capacity = 1 << 16 };
+
+  /// Aggregated values of a name, durations are in microseconds.
+  struct Metric
+  {
+    Metric();
+
+    QString name;
+    bool counter;
+    qint64 count;
+    qint64 total;
+    qint64 maximum;
+    qint64 last;
+  };
+
+  static CTracer * instance();
+
+  static bool isEnabled()
+  {
+    return s_enabled != 0;
+  }
+  static void setEnabled(bool value);
+
+  /// Microseconds elapsed since the creation of the tracer.
+  qint64 now() const;
+
+  void record(const char *name, qint64 start, qint64 duration);
+  void count(const char *name, qint64 value);
+
+  QList<Metric> metrics() const;
+  void clear();
+
+  bool exportChromeTrace(const QString & filename) const;
+
+private:
+  struct Event
+  {
+    const char *name;
+    bool counter;
+    qint64 start;
+    qint64 value;
+    Qt::HANDLE thread;
+  };
+
+  CTracer();
+  void append(const Event & event);
+
+  mutable QMutex m_mutex;
+  QElapsedTimer m_clock;
+  QVector<Event> m_events;
+  int m_next;
+  bool m_wrapped;
+  QHash<const char*, Metric> m_metrics;
+
+  static QAtomicInt s_enabled;
+};
+
+/** \class CTraceScope "tracer.hh"
+ * \brief CTraceScope records the time spent in its scope
+ *
+ * A null name disables the scope, which allows computing the name
+ * only when tracing.
+ */
+class CTraceScope
+{
+public:
+  CTraceScope(const char *name)
+    : m_name(CTracer::isEnabled() ? name : 0)
+    , m_start(m_name ? CTracer::instance()->now() : 0)
+  {}
+
+  ~CTraceScope()
+  {
+    finish();
+  }
+
+  /// Records the scope before its end, for stages of a function.
+  void finish()
+  {
+    if (m_name)
+      {
+	CTracer *tracer = CTracer::instance();
+	tracer->record(m_name, m_start, tracer->now() - m_start);
+	m_name = 0;
+      }
+  }
+
+private:
+  const char *m_name;
+  qint64 m_start;
+};
+
+#define SB_TRACE_CONCAT2(a, b) a##b
+#define SB_TRACE_CONCAT(a, b) SB_TRACE_CONCAT2(a, b)
+
+/// Records the time spent until the end of the enclosing scope.
+#define SB_TRACE(name) \
+  CTraceScope SB_TRACE_CONCAT(traceScope, __LINE__)(name)
+
+/// Records the value of a counter.
+#define SB_TRACE_COUNT(name, value)		\
+  do {						\
+    if (CTracer::isEnabled())			\
+      CTracer::instance()->count(name, value);	\
+  } while (0)
+
+#endif // __TRACER_HH__
@@ -0,0 +1,221 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "ui-update-scheduler.hh"
+
+#include <QProgressBar>
+#include <QStatusBar>
+#include <QTextEdit>
+#include <QThread>
+
+namespace
+{
+  // throughput is not meaningful before
+  const int MinimalDuration = 500;
+
+  QString duration(int seconds)
+  {
+    return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+  }
+}
+
+//------------------------------------------------------------------------------
+CUiUpdateScheduler::CUiUpdateScheduler(QStatusBar *AStatusBar,
+				       QProgressBar *AProgressBar,
+				       QTextEdit *ALog, QObject *parent)
+  : QObject(parent)
+  , m_statusBar(AStatusBar)
+  , m_progressBar(AProgressBar)
+  , m_log(ALog)
+  , m_timer()
+  , m_mutex()
+  , m_task()
+  , m_status()
+  , m_endMessage()
+  , m_pendingLog()
+  , m_total(0)
+  , m_done(0)
+  , m_running(false)
+  , m_ended(false)
+  , m_dirty(false)
+  , m_scheduled(false)
+  , m_started()
+  , m_lastFlush()
+{
+  m_timer.setSingleShot(true);
+  connect(&m_timer, SIGNAL(timeout()), SLOT(flush()));
+  m_started.start();
+  m_lastFlush.start();
+}
+//------------------------------------------------------------------------------
+CUiUpdateScheduler::~CUiUpdateScheduler()
+{}
+//------------------------------------------------------------------------------
+void CUiUpdateScheduler::beginTask(const QString & name, int total)
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    m_task = name;
+    m_status.clear();
+    m_total = total;
+    m_done = 0;
+    m_running = true;
+    m_ended = false;
+    m_dirty = true;
+    m_started.restart();
+  }
+  update();
+}
+//------------------------------------------------------------------------------
+void CUiUpdateScheduler::advance(int steps)
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    m_done += steps;
+    m_dirty = true;
+  }
+  update();
+}
+//------------------------------------------------------------------------------
+void CUiUpdateScheduler::setStatus(const QString & status)
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    m_status = status;
+    m_dirty = true;
+  }
+  update();
+}
+//------------------------------------------------------------------------------
+void CUiUpdateScheduler::endTask(const QString & message)
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    m_running = false;
+    m_ended = true;
+    m_endMessage = message;
+    m_dirty = true;
+  }
+  // the end of a task is always displayed
+  if (QThread::currentThread() == thread())
+    flush();
+  else
+    update();
+}
+//------------------------------------------------------------------------------
+void CUiUpdateScheduler::appendLog(const QString & text)
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    m_pendingLog << text;
+    m_dirty = true;
+  }
+  update();
+}
+//------------------------------------------------------------------------------
+void CUiUpdateScheduler::update()
+{
+  QMutexLocker locker(&m_mutex);
+
+  // an operation blocking the event loop flushes when it is due, the
+  // scheduled flush does not run until the operation ends
+  if (QThread::currentThread() == thread() && m_lastFlush.elapsed() >= FrameInterval)
+    {
+      locker.unlock();
+      flush();
+      if (m_statusBar)
+	m_statusBar->repaint();
+      return;
+    }
+
+  if (m_scheduled)
+    return;
+
+  m_scheduled = true;
+  QMetaObject::invokeMethod(this, "scheduleFlush", Qt::QueuedConnection);
+}
+//------------------------------------------------------------------------------
+void CUiUpdateScheduler::scheduleFlush()
+{
+  int elapsed;
+  {
+    QMutexLocker locker(&m_mutex);
+    elapsed = m_lastFlush.elapsed();
+  }
+  m_timer.start(qMax(0, FrameInterval - elapsed));
+}
+//------------------------------------------------------------------------------
+QString CUiUpdateScheduler::message() const
+{
+  QString message = m_status.isEmpty() ? m_task : QString("%1: %2").arg(m_task).arg(m_status);
+
+  int elapsed = m_started.elapsed();
+  if (elapsed < MinimalDuration || m_done == 0)
+    return message;
+
+  double rate = m_done * 1000.0 / elapsed;
+  if (m_total <= 0)
+    return tr("%1 (%2, %3/s)").arg(message).arg(m_done).arg(qRound(rate));
+
+  int remaining = qRound(qMax(0, m_total - m_done) / rate);
+  return tr("%1 (%2/%3, %4/s, %5 left)").arg(message).arg(m_done).arg(m_total)
+    .arg(qRound(rate)).arg(duration(remaining));
+}
+//------------------------------------------------------------------------------
+void CUiUpdateScheduler::flush()
+{
+  QMutexLocker locker(&m_mutex);
+  m_scheduled = false;
+  m_timer.stop();
+  m_lastFlush.restart();
+  if (!m_dirty)
+    return;
+
+  m_dirty = false;
+  QString text = m_running ? message() : m_endMessage;
+  QStringList log = m_pendingLog;
+  m_pendingLog.clear();
+  bool running = m_running;
+  bool ended = m_ended;
+  int total = m_total;
+  int done = m_done;
+  m_ended = false;
+  locker.unlock();
+
+  if (m_log && !log.isEmpty())
+    m_log->append(log.join("\n"));
+
+  if (m_progressBar)
+    {
+      if (running)
+	{
+	  m_progressBar->setTextVisible(total > 0);
+	  m_progressBar->setRange(0, qMax(0, total));
+	  m_progressBar->setValue(qMin(done, qMax(0, total)));
+	  m_progressBar->show();
+	}
+      else if (ended)
+	{
+	  m_progressBar->setTextVisible(false);
+	  m_progressBar->setRange(0, 0);
+	  m_progressBar->hide();
+	}
+    }
+
+  if (m_statusBar && (running || (ended && !text.isEmpty())))
+    m_statusBar->showMessage(text);
+}
@@ -0,0 +1,104 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file ui-update-scheduler.hh
+ *
+ * Coalescing of the progress and status updates of long operations.
+ *
+ * Operations report every step, the widgets are updated at most once
+ * per frame with the latest state. While an operation blocks the
+ * event loop, a due update is painted immediately so that progress
+ * remains visible.
+ *
+ */
+#ifndef __UI_UPDATE_SCHEDULER_HH__
+#define __UI_UPDATE_SCHEDULER_HH__
+
+#include <QObject>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QTime>
+#include <QTimer>
+
+class QStatusBar;
+class QProgressBar;
+class QTextEdit;
+
+/** \class CUiUpdateScheduler "ui-update-scheduler.hh"
+ * \brief CUiUpdateScheduler updates the status bar, progress bar and log
+ *
+ * Its methods may be called from any thread, the widgets are only
+ * updated from the thread of the scheduler.
+ */
+class CUiUpdateScheduler : public QObject
+{
+  Q_OBJECT
+
+public:
+  /// Minimal delay between two updates of the widgets, in ms.
+  enum { FrameInterval = 16 };
+
+  CUiUpdateScheduler(QStatusBar *statusBar, QProgressBar *progressBar,
+		     QTextEdit *log, QObject *parent = 0);
+  ~CUiUpdateScheduler();
+
+  /// Starts a task of \a total steps, 0 if the number is unknown.
+  void beginTask(const QString & name, int total = 0);
+  void advance(int steps = 1);
+  /// Detail displayed after the name of the task, such as the file
+  /// being processed.
+  void setStatus(const QString & status);
+  /// Ends the current task and displays \a message.
+  void endTask(const QString & message = QString());
+
+  void appendLog(const QString & text);
+
+public slots:
+  /// Updates the widgets with the pending changes.
+  void flush();
+
+private slots:
+  void scheduleFlush();
+
+private:
+  void update();
+  QString message() const;
+
+  QStatusBar *m_statusBar;
+  QProgressBar *m_progressBar;
+  QTextEdit *m_log;
+  QTimer m_timer;
+
+  mutable QMutex m_mutex;
+  QString m_task;
+  QString m_status;
+  QString m_endMessage;
+  QStringList m_pendingLog;
+  int m_total;
+  int m_done;
+  bool m_running;
+  bool m_ended;
+  bool m_dirty;
+  bool m_scheduled;
+  QTime m_started;
+  QTime m_lastFlush;
+};
+
+#endif // __UI_UPDATE_SCHEDULER_HH__
@@ -0,0 +1,266 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "bitset.hh"
+
+namespace
+{
+  inline int popcount(quint64 word)
+  {
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word; ++count)
+      word &= word - 1;
+    return count;
+#endif
+  }
+
+  inline int lowestBit(quint64 word)
+  {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while (!(word & 1))
+      {
+	word >>= 1;
+	++bit;
+      }
+    return bit;
+#endif
+  }
+
+  inline int wordCount(int size)
+  {
+    return (size + 63) / 64;
+  }
+}
+
+//------------------------------------------------------------------------------
+CBitSet::CBitSet(int ASize)
+  : m_words(wordCount(ASize), 0)
+  , m_size(ASize)
+  , m_count(0)
+{}
+//------------------------------------------------------------------------------
+int CBitSet::size() const
+{
+  return m_size;
+}
+//------------------------------------------------------------------------------
+void CBitSet::resize(int ASize)
+{
+  m_words.resize(wordCount(ASize));
+  if (ASize > m_size)
+    {
+      // clear the words that were appended
+      for (int i = wordCount(m_size); i < m_words.size(); ++i)
+	m_words[i] = 0;
+      m_size = ASize;
+    }
+  else
+    {
+      m_size = ASize;
+      clearPadding();
+      recount();
+    }
+}
+//------------------------------------------------------------------------------
+int CBitSet::count() const
+{
+  return m_count;
+}
+//------------------------------------------------------------------------------
+bool CBitSet::isEmpty() const
+{
+  return m_count == 0;
+}
+//------------------------------------------------------------------------------
+bool CBitSet::testBit(int i) const
+{
+  if (i < 0 || i >= m_size)
+    return false;
+  return m_words[i >> 6] & (Q_UINT64_C(1) << (i & 63));
+}
+//------------------------------------------------------------------------------
+void CBitSet::setBit(int i)
+{
+  Q_ASSERT(i >= 0 && i < m_size);
+  quint64 & word = m_words[i >> 6];
+  quint64 mask = Q_UINT64_C(1) << (i & 63);
+  if (!(word & mask))
+    {
+      word |= mask;
+      ++m_count;
+    }
+}
+//------------------------------------------------------------------------------
+void CBitSet::clearBit(int i)
+{
+  Q_ASSERT(i >= 0 && i < m_size);
+  quint64 & word = m_words[i >> 6];
+  quint64 mask = Q_UINT64_C(1) << (i & 63);
+  if (word & mask)
+    {
+      word &= ~mask;
+      --m_count;
+    }
+}
+//------------------------------------------------------------------------------
+void CBitSet::setBit(int i, bool value)
+{
+  if (value)
+    setBit(i);
+  else
+    clearBit(i);
+}
+//------------------------------------------------------------------------------
+void CBitSet::fill(bool value)
+{
+  m_words.fill(value ? ~Q_UINT64_C(0) : 0);
+  clearPadding();
+  m_count = value ? m_size : 0;
+}
+//------------------------------------------------------------------------------
+void CBitSet::invert()
+{
+  quint64 *words = m_words.data();
+  for (int i = 0; i < m_words.size(); ++i)
+    words[i] = ~words[i];
+  clearPadding();
+  m_count = m_size - m_count;
+}
+//------------------------------------------------------------------------------
+int CBitSet::nextSetBit(int from) const
+{
+  if (from < 0)
+    from = 0;
+  if (from >= m_size)
+    return -1;
+
+  int index = from >> 6;
+  quint64 word = m_words[index] & (~Q_UINT64_C(0) << (from & 63));
+  while (!word)
+    {
+      if (++index >= m_words.size())
+	return -1;
+      word = m_words[index];
+    }
+  return (index << 6) + lowestBit(word);
+}
+//------------------------------------------------------------------------------
+CBitSet & CBitSet::operator&=(const CBitSet & other)
+{
+  if (other.m_size > m_size)
+    resize(other.m_size);
+
+  quint64 *words = m_words.data();
+  const quint64 *otherWords = other.m_words.constData();
+  int common = other.m_words.size();
+  for (int i = 0; i < common; ++i)
+    words[i] &= otherWords[i];
+  for (int i = common; i < m_words.size(); ++i)
+    words[i] = 0;
+  recount();
+  return *this;
+}
+//------------------------------------------------------------------------------
+CBitSet & CBitSet::operator|=(const CBitSet & other)
+{
+  if (other.m_size > m_size)
+    resize(other.m_size);
+
+  quint64 *words = m_words.data();
+  const quint64 *otherWords = other.m_words.constData();
+  for (int i = 0; i < other.m_words.size(); ++i)
+    words[i] |= otherWords[i];
+  recount();
+  return *this;
+}
+//------------------------------------------------------------------------------
+CBitSet & CBitSet::operator^=(const CBitSet & other)
+{
+  if (other.m_size > m_size)
+    resize(other.m_size);
+
+  quint64 *words = m_words.data();
+  const quint64 *otherWords = other.m_words.constData();
+  for (int i = 0; i < other.m_words.size(); ++i)
+    words[i] ^= otherWords[i];
+  recount();
+  return *this;
+}
+//------------------------------------------------------------------------------
+CBitSet & CBitSet::subtract(const CBitSet & other)
+{
+  quint64 *words = m_words.data();
+  const quint64 *otherWords = other.m_words.constData();
+  int common = qMin(m_words.size(), other.m_words.size());
+  for (int i = 0; i < common; ++i)
+    words[i] &= ~otherWords[i];
+  recount();
+  return *this;
+}
+//------------------------------------------------------------------------------
+CBitSet CBitSet::operator&(const CBitSet & other) const
+{
+  CBitSet result(*this);
+  result &= other;
+  return result;
+}
+//------------------------------------------------------------------------------
+CBitSet CBitSet::operator|(const CBitSet & other) const
+{
+  CBitSet result(*this);
+  result |= other;
+  return result;
+}
+//------------------------------------------------------------------------------
+CBitSet CBitSet::operator^(const CBitSet & other) const
+{
+  CBitSet result(*this);
+  result ^= other;
+  return result;
+}
+//------------------------------------------------------------------------------
+bool CBitSet::operator==(const CBitSet & other) const
+{
+  return m_size == other.m_size && m_count == other.m_count
+    && m_words == other.m_words;
+}
+//------------------------------------------------------------------------------
+bool CBitSet::operator!=(const CBitSet & other) const
+{
+  return !(*this == other);
+}
+//------------------------------------------------------------------------------
+void CBitSet::clearPadding()
+{
+  if (m_size & 63)
+    m_words[m_words.size() - 1] &= (Q_UINT64_C(1) << (m_size & 63)) - 1;
+}
+//------------------------------------------------------------------------------
+void CBitSet::recount()
+{
+  int count = 0;
+  const quint64 *words = m_words.constData();
+  for (int i = 0; i < m_words.size(); ++i)
+    count += popcount(words[i]);
+  m_count = count;
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file bitset.hh
+ *
+ * Bitmap of song ids.
+ *
+ * Unlike QBitArray, the number of set bits is maintained as a running
+ * total and set bits can be enumerated word by word.
+ *
+ */
+#ifndef __BITSET_HH__
+#define __BITSET_HH__
+
+#include <QVector>
+
+class CBitSet
+{
+public:
+  CBitSet(int size = 0);
+
+  int size() const;
+  void resize(int size);
+
+  /// Number of bits set, in constant time.
+  int count() const;
+  bool isEmpty() const;
+
+  bool testBit(int i) const;
+  void setBit(int i);
+  void setBit(int i, bool value);
+  void clearBit(int i);
+  void fill(bool value);
+  void invert();
+
+  /// Returns the index of the first set bit at or after \a from, or -1.
+  int nextSetBit(int from) const;
+
+  CBitSet & operator&=(const CBitSet & other);
+  CBitSet & operator|=(const CBitSet & other);
+  CBitSet & operator^=(const CBitSet & other);
+  CBitSet & subtract(const CBitSet & other);
+
+  CBitSet operator&(const CBitSet & other) const;
+  CBitSet operator|(const CBitSet & other) const;
+  CBitSet operator^(const CBitSet & other) const;
+
+  bool operator==(const CBitSet & other) const;
+  bool operator!=(const CBitSet & other) const;
+
+private:
+  void clearPadding();
+  void recount();
+
+  QVector<quint64> m_words;
+  int m_size;
+  int m_count;
+};
+
+#endif // __BITSET_HH__
@@ -0,0 +1,149 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "byte-search.hh"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+  inline bool isAsciiLetter(unsigned char c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  }
+
+  inline unsigned char toAsciiLower(unsigned char c)
+  {
+    return (c >= 'A' && c <= 'Z') ? c | 0x20 : c;
+  }
+
+#if defined(__GNUC__)
+  inline int lowestBit(unsigned int mask)
+  {
+    return __builtin_ctz(mask);
+  }
+#else
+  inline int lowestBit(unsigned int mask)
+  {
+    int bit = 0;
+    while (!(mask & 1))
+      {
+	mask >>= 1;
+	++bit;
+      }
+    return bit;
+  }
+#endif
+}
+
+//------------------------------------------------------------------------------
+CByteSearch::CByteSearch(const QByteArray & APattern, bool ACaseSensitive)
+  : m_pattern(APattern)
+  , m_caseSensitive(ACaseSensitive)
+  , m_first(0)
+  , m_last(0)
+  , m_firstFold(0)
+  , m_lastFold(0)
+{
+  if (!m_caseSensitive)
+    for (int i = 0; i < m_pattern.size(); ++i)
+      m_pattern[i] = char(toAsciiLower(m_pattern[i]));
+
+  if (m_pattern.isEmpty())
+    return;
+
+  // a letter matches both cases once bit 0x20 is set in the data
+  m_first = m_pattern[0];
+  m_last = m_pattern[m_pattern.size() - 1];
+  if (!m_caseSensitive)
+    {
+      m_firstFold = isAsciiLetter(m_first) ? 0x20 : 0;
+      m_lastFold = isAsciiLetter(m_last) ? 0x20 : 0;
+    }
+}
+//------------------------------------------------------------------------------
+const QByteArray & CByteSearch::pattern() const
+{
+  return m_pattern;
+}
+//------------------------------------------------------------------------------
+bool CByteSearch::caseSensitive() const
+{
+  return m_caseSensitive;
+}
+//------------------------------------------------------------------------------
+bool CByteSearch::matchesAt(const char *data) const
+{
+  const int size = m_pattern.size();
+  if (m_caseSensitive)
+    return memcmp(data, m_pattern.constData(), size) == 0;
+
+  const char *pattern = m_pattern.constData();
+  for (int i = 0; i < size; ++i)
+    if (toAsciiLower(data[i]) != (unsigned char) pattern[i])
+      return false;
+  return true;
+}
+//------------------------------------------------------------------------------
+int CByteSearch::indexIn(const char *data, int size, int from) const
+{
+  const int length = m_pattern.size();
+  if (length == 0)
+    return from <= size ? from : -1;
+
+  // last position where the pattern may start
+  const int end = size - length;
+  int i = qMax(from, 0);
+
+#if defined(__SSE2__)
+  const __m128i first = _mm_set1_epi8(char(m_first));
+  const __m128i last = _mm_set1_epi8(char(m_last));
+  const __m128i firstFold = _mm_set1_epi8(char(m_firstFold));
+  const __m128i lastFold = _mm_set1_epi8(char(m_lastFold));
+
+  for (; i + 15 <= end; i += 16)
+    {
+      __m128i head = _mm_loadu_si128((const __m128i *)(data + i));
+      __m128i tail = _mm_loadu_si128((const __m128i *)(data + i + length - 1));
+      __m128i candidates =
+	_mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(head, firstFold), first),
+		      _mm_cmpeq_epi8(_mm_or_si128(tail, lastFold), last));
+
+      unsigned int mask = _mm_movemask_epi8(candidates);
+      while (mask)
+	{
+	  int bit = lowestBit(mask);
+	  if (matchesAt(data + i + bit))
+	    return i + bit;
+	  mask &= mask - 1;
+	}
+    }
+#endif
+
+  for (; i <= end; ++i)
+    {
+      if (((unsigned char) data[i] | m_firstFold) == m_first
+	  && ((unsigned char) data[i + length - 1] | m_lastFold) == m_last
+	  && matchesAt(data + i))
+	return i;
+    }
+  return -1;
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file byte-search.hh
+ *
+ * Substring search in raw bytes.
+ *
+ * Candidates are found 16 bytes at a time by comparing the first and
+ * the last byte of the pattern (SSE2 when available), and are then
+ * checked byte by byte. Case insensitive matching only folds ASCII
+ * letters.
+ *
+ */
+#ifndef __BYTE_SEARCH_HH__
+#define __BYTE_SEARCH_HH__
+
+#include <QByteArray>
+
+class CByteSearch
+{
+public:
+  CByteSearch(const QByteArray & pattern, bool caseSensitive = true);
+
+  const QByteArray & pattern() const;
+  bool caseSensitive() const;
+
+  /// Returns the offset of the first match in data[from, size), or -1.
+  int indexIn(const char *data, int size, int from = 0) const;
+
+private:
+  bool matchesAt(const char *data) const;
+
+  QByteArray m_pattern;
+  bool m_caseSensitive;
+  unsigned char m_first;
+  unsigned char m_last;
+  unsigned char m_firstFold;
+  unsigned char m_lastFold;
+};
+
+#endif // __BYTE_SEARCH_HH__
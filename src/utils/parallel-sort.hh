@@ -0,0 +1,70 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file parallel-sort.hh
+ *
+ * Stable merge sort whose halves are sorted concurrently.
+ *
+ */
+#ifndef __PARALLEL_SORT_HH__
+#define __PARALLEL_SORT_HH__
+
+#include <algorithm>
+#include <QThread>
+#include <QtConcurrentRun>
+
+namespace SbUtils
+{
+  /// Ranges smaller than this are sorted by the calling thread.
+  const int ParallelSortThreshold = 8192;
+
+  template <typename RandomAccessIterator, typename LessThan>
+  void parallelSortRange(RandomAccessIterator begin, RandomAccessIterator end,
+			 LessThan lessThan, int threshold, int depth)
+  {
+    if (depth <= 0 || end - begin < threshold)
+      {
+	std::stable_sort(begin, end, lessThan);
+	return;
+      }
+
+    RandomAccessIterator middle = begin + (end - begin) / 2;
+    QFuture<void> future =
+      QtConcurrent::run(parallelSortRange<RandomAccessIterator, LessThan>,
+			begin, middle, lessThan, threshold, depth - 1);
+    parallelSortRange(middle, end, lessThan, threshold, depth - 1);
+    future.waitForFinished();
+    std::inplace_merge(begin, middle, end, lessThan);
+  }
+
+  /// Stable sort of [begin, end) using every core above \a threshold
+  /// elements. \a lessThan must be safe to call from several threads.
+  template <typename RandomAccessIterator, typename LessThan>
+  void parallelSort(RandomAccessIterator begin, RandomAccessIterator end,
+		    LessThan lessThan, int threshold = ParallelSortThreshold)
+  {
+    // split until there is one range per core
+    int depth = 0;
+    for (int cores = QThread::idealThreadCount(); cores > 1; cores >>= 1)
+      ++depth;
+    parallelSortRange(begin, end, lessThan, qMax(threshold, 2), depth);
+  }
+}
+
+#endif // __PARALLEL_SORT_HH__
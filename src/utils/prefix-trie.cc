@@ -0,0 +1,168 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "prefix-trie.hh"
+
+//------------------------------------------------------------------------------
+CPrefixTrie::CPrefixTrie()
+  : m_nodes()
+  , m_values()
+  , m_size(0)
+{
+  clear();
+}
+//------------------------------------------------------------------------------
+void CPrefixTrie::clear()
+{
+  Node root = { 0, -1, -1, 0, 0, -1 };
+  m_nodes.clear();
+  m_nodes.append(root);
+  m_values.clear();
+  m_size = 0;
+}
+//------------------------------------------------------------------------------
+int CPrefixTrie::size() const
+{
+  return m_size;
+}
+//------------------------------------------------------------------------------
+bool CPrefixTrie::contains(const QString & value) const
+{
+  int node = find(value.toLower());
+  return node >= 0 && m_nodes[node].count > 0;
+}
+//------------------------------------------------------------------------------
+int CPrefixTrie::child(int node, ushort key) const
+{
+  // siblings are kept sorted by key
+  int current = m_nodes[node].firstChild;
+  while (current >= 0 && m_nodes[current].key < key)
+    current = m_nodes[current].nextSibling;
+  if (current >= 0 && m_nodes[current].key == key)
+    return current;
+  return -1;
+}
+//------------------------------------------------------------------------------
+int CPrefixTrie::addChild(int node, ushort key)
+{
+  int previous = -1;
+  int current = m_nodes[node].firstChild;
+  while (current >= 0 && m_nodes[current].key < key)
+    {
+      previous = current;
+      current = m_nodes[current].nextSibling;
+    }
+  if (current >= 0 && m_nodes[current].key == key)
+    return current;
+
+  Node added = { key, -1, current, 0, 0, -1 };
+  int index = m_nodes.size();
+  m_nodes.append(added);
+  if (previous < 0)
+    m_nodes[node].firstChild = index;
+  else
+    m_nodes[previous].nextSibling = index;
+  return index;
+}
+//------------------------------------------------------------------------------
+int CPrefixTrie::find(const QString & key) const
+{
+  int node = 0;
+  for (int i = 0; i < key.size() && node >= 0; ++i)
+    node = child(node, key[i].unicode());
+  return node;
+}
+//------------------------------------------------------------------------------
+void CPrefixTrie::insert(const QString & value)
+{
+  if (value.isEmpty())
+    return;
+
+  QString key = value.toLower();
+  int node = 0;
+  ++m_nodes[0].weight;
+  for (int i = 0; i < key.size(); ++i)
+    {
+      node = addChild(node, key[i].unicode());
+      ++m_nodes[node].weight;
+    }
+
+  Node & last = m_nodes[node];
+  if (last.count++ == 0)
+    {
+      ++m_size;
+      // the first spelling inserted is the one proposed
+      if (last.value < 0)
+	{
+	  last.value = m_values.size();
+	  m_values.append(value);
+	}
+    }
+}
+//------------------------------------------------------------------------------
+void CPrefixTrie::remove(const QString & value)
+{
+  if (value.isEmpty())
+    return;
+
+  QString key = value.toLower();
+  int node = find(key);
+  if (node < 0 || m_nodes[node].count == 0)
+    return;
+
+  // nodes are kept, only their weight is updated so that empty
+  // branches are skipped when completing
+  if (--m_nodes[node].count == 0)
+    --m_size;
+  node = 0;
+  --m_nodes[0].weight;
+  for (int i = 0; i < key.size(); ++i)
+    {
+      node = child(node, key[i].unicode());
+      --m_nodes[node].weight;
+    }
+}
+//------------------------------------------------------------------------------
+QStringList CPrefixTrie::complete(const QString & prefix, int limit) const
+{
+  QStringList result;
+  int start = find(prefix.toLower());
+  if (start < 0 || m_nodes[start].weight == 0)
+    return result;
+
+  // depth first traversal in key order
+  QVector<int> stack;
+  stack.append(start);
+  while (!stack.isEmpty() && (limit < 0 || result.size() < limit))
+    {
+      int node = stack.last();
+      stack.pop_back();
+
+      const Node & current = m_nodes[node];
+      if (current.count > 0)
+	result << m_values[current.value];
+
+      // push the children in reverse order to visit them in key order
+      int first = stack.size();
+      for (int c = current.firstChild; c >= 0; c = m_nodes[c].nextSibling)
+	if (m_nodes[c].weight > 0)
+	  stack.append(c);
+      for (int i = first, j = stack.size() - 1; i < j; ++i, --j)
+	qSwap(stack[i], stack[j]);
+    }
+  return result;
+}
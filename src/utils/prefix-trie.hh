@@ -0,0 +1,73 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file prefix-trie.hh
+ *
+ * Case insensitive prefix tree of distinct strings.
+ *
+ * Each string is counted as many times as it is inserted so that it
+ * disappears once all its occurrences are removed. Nodes are stored
+ * in a single array and linked to their first child and next sibling.
+ *
+ */
+#ifndef __PREFIX_TRIE_HH__
+#define __PREFIX_TRIE_HH__
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class CPrefixTrie
+{
+public:
+  CPrefixTrie();
+
+  void insert(const QString & value);
+  void remove(const QString & value);
+  void clear();
+
+  /// Number of distinct strings.
+  int size() const;
+  bool contains(const QString & value) const;
+
+  /// Returns at most \a limit distinct strings starting with \a prefix,
+  /// in case insensitive order.
+  QStringList complete(const QString & prefix, int limit = -1) const;
+
+private:
+  struct Node
+  {
+    ushort key;
+    int firstChild;
+    int nextSibling;
+    int count;   // occurrences of the string ending at this node
+    int weight;  // occurrences of the strings below this node
+    int value;   // index in m_values, or -1
+  };
+
+  int find(const QString & key) const;
+  int child(int node, ushort key) const;
+  int addChild(int node, ushort key);
+
+  QVector<Node> m_nodes;
+  QVector<QString> m_values;
+  int m_size;
+};
+
+#endif // __PREFIX_TRIE_HH__
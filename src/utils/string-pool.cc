@@ -0,0 +1,52 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "string-pool.hh"
+
+#include <QMutexLocker>
+
+//------------------------------------------------------------------------------
+CStringPool::CStringPool()
+  : m_mutex()
+  , m_strings()
+{}
+//------------------------------------------------------------------------------
+QString CStringPool::intern(const QString & str)
+{
+  if (str.isEmpty())
+    return str;
+
+  QMutexLocker locker(&m_mutex);
+  QSet<QString>::const_iterator it = m_strings.constFind(str);
+  if (it != m_strings.constEnd())
+    return *it;
+
+  m_strings.insert(str);
+  return str;
+}
+//------------------------------------------------------------------------------
+int CStringPool::size() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_strings.size();
+}
+//------------------------------------------------------------------------------
+void CStringPool::clear()
+{
+  QMutexLocker locker(&m_mutex);
+  m_strings.clear();
+}
@@ -0,0 +1,52 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file string-pool.hh
+ *
+ * Table of interned strings.
+ *
+ * The songs of an artist, an album or a language share one copy of
+ * the value instead of each holding the one read from its file.
+ *
+ */
+#ifndef __STRING_POOL_HH__
+#define __STRING_POOL_HH__
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+class CStringPool
+{
+public:
+  CStringPool();
+
+  /// Returns the string of the pool equal to \a str, which is added
+  /// if there is none. Can be called from several threads.
+  QString intern(const QString & str);
+
+  int size() const;
+  void clear();
+
+private:
+  mutable QMutex m_mutex;
+  QSet<QString> m_strings;
+};
+
+#endif // __STRING_POOL_HH__
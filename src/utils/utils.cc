@@ -20,31 +20,317 @@
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QDebug>
+#include <QVarLengthArray>
+
+#include <cstring>
+#include <cwchar>
 
 #include "utils.hh"
 
+namespace
+{
+  // Tables of the LaTeX and transliteration decoders, constant
+  // initialised so that they are laid out by the compiler and need no
+  // construction at run time.
+
+  enum Accent { Acute, Grave, Circumflex, Diaeresis, Tilde, Cedilla, AccentCount };
+
+  // letters composed with each accent, 0 where the letter has none
+  struct Composition
+  {
+    char letter;
+    ushort composed[AccentCount];
+  };
+
+  const Composition compositions[] = {
+    // letter  acute   grave   circ    diaer   tilde   cedilla
+    { 'a', { 0x00E1, 0x00E0, 0x00E2, 0x00E4, 0x00E3, 0 } },
+    { 'c', { 0x0107, 0,      0x0109, 0,      0,      0x00E7 } },
+    { 'e', { 0x00E9, 0x00E8, 0x00EA, 0x00EB, 0,      0x0229 } },
+    { 'i', { 0x00ED, 0x00EC, 0x00EE, 0x00EF, 0x0129, 0 } },
+    { 'n', { 0x0144, 0,      0,      0,      0x00F1, 0 } },
+    { 'o', { 0x00F3, 0x00F2, 0x00F4, 0x00F6, 0x00F5, 0 } },
+    { 's', { 0x015B, 0,      0x015D, 0,      0,      0x015F } },
+    { 'u', { 0x00FA, 0x00F9, 0x00FB, 0x00FC, 0x0169, 0 } },
+    { 'y', { 0x00FD, 0,      0x0177, 0x00FF, 0,      0 } },
+    { 'z', { 0x017A, 0,      0,      0,      0,      0 } },
+    { 'A', { 0x00C1, 0x00C0, 0x00C2, 0x00C4, 0x00C3, 0 } },
+    { 'C', { 0x0106, 0,      0x0108, 0,      0,      0x00C7 } },
+    { 'E', { 0x00C9, 0x00C8, 0x00CA, 0x00CB, 0,      0x0228 } },
+    { 'I', { 0x00CD, 0x00CC, 0x00CE, 0x00CF, 0x0128, 0 } },
+    { 'N', { 0x0143, 0,      0,      0,      0x00D1, 0 } },
+    { 'O', { 0x00D3, 0x00D2, 0x00D4, 0x00D6, 0x00D5, 0 } },
+    { 'S', { 0x015A, 0,      0x015C, 0,      0,      0x015E } },
+    { 'U', { 0x00DA, 0x00D9, 0x00DB, 0x00DC, 0x0168, 0 } },
+    { 'Y', { 0x00DD, 0,      0x0176, 0x0178, 0,      0 } },
+    { 'Z', { 0x0179, 0,      0,      0,      0,      0 } }
+  };
+  const int compositionCount = sizeof(compositions) / sizeof(compositions[0]);
+
+  // ligatures and letters written as control words
+  struct ControlWord
+  {
+    const char *name;
+    ushort character;
+  };
+
+  const ControlWord controlWords[] = {
+    { "oe", 0x0153 }, { "OE", 0x0152 },
+    { "ae", 0x00E6 }, { "AE", 0x00C6 },
+    { "aa", 0x00E5 }, { "AA", 0x00C5 },
+    { "o",  0x00F8 }, { "O",  0x00D8 },
+    { "l",  0x0142 }, { "L",  0x0141 },
+    { "ss", 0x00DF }, { "i",  0x0131 }
+  };
+  const int controlWordCount = sizeof(controlWords) / sizeof(controlWords[0]);
+
+  // ASCII spelling of the letters of the Latin-1 Supplement, from
+  // U+00C0, 0 for the signs that are not letters
+  const char *latin1Letters[] = {
+    "A", "A", "A", "A", "A", "A", "AE", "C",
+    "E", "E", "E", "E", "I", "I", "I", "I",
+    "D", "N", "O", "O", "O", "O", "O", 0,
+    "O", "U", "U", "U", "U", "Y", "TH", "ss",
+    "a", "a", "a", "a", "a", "a", "ae", "c",
+    "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", 0,
+    "o", "u", "u", "u", "u", "y", "th", "y"
+  };
+
+  // ASCII spelling of the other letters produced by latexToUtf8(),
+  // sorted by code point
+  struct Transliteration
+  {
+    ushort character;
+    const char *ascii;
+  };
+
+  const Transliteration latinExtendedLetters[] = {
+    { 0x0106, "C" }, { 0x0107, "c" }, { 0x0108, "C" }, { 0x0109, "c" },
+    { 0x0128, "I" }, { 0x0129, "i" }, { 0x0131, "i" },
+    { 0x0141, "L" }, { 0x0142, "l" }, { 0x0143, "N" }, { 0x0144, "n" },
+    { 0x0152, "OE" }, { 0x0153, "oe" },
+    { 0x015A, "S" }, { 0x015B, "s" }, { 0x015C, "S" }, { 0x015D, "s" },
+    { 0x015E, "S" }, { 0x015F, "s" },
+    { 0x0168, "U" }, { 0x0169, "u" },
+    { 0x0176, "Y" }, { 0x0177, "y" }, { 0x0178, "Y" },
+    { 0x0179, "Z" }, { 0x017A, "z" },
+    { 0x0228, "E" }, { 0x0229, "e" }
+  };
+  const int latinExtendedLetterCount =
+    sizeof(latinExtendedLetters) / sizeof(latinExtendedLetters[0]);
+
+  inline bool isAsciiLetter(QChar c)
+  {
+    ushort u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z');
+  }
+
+  ushort compose(Accent accent, char letter)
+  {
+    for (int i = 0; i < compositionCount; ++i)
+      if (compositions[i].letter == letter)
+	return compositions[i].composed[accent];
+    return 0;
+  }
+
+  // Decodes the argument of an accent: a letter, \i, or either of
+  // them in braces. Returns the number of characters read or -1.
+  int decodeAccent(Accent accent, const QChar *s, int n, QString & result)
+  {
+    char letter = 0;
+    int length = 0;
+    if (n >= 3 && s[0] == '{' && isAsciiLetter(s[1]) && s[2] == '}')
+      {
+	letter = s[1].toLatin1();
+	length = 3;
+      }
+    else if (n >= 4 && s[0] == '{' && s[1] == '\\' && s[2] == 'i' && s[3] == '}')
+      {
+	letter = 'i';
+	length = 4;
+      }
+    else if (n >= 2 && s[0] == '\\' && s[1] == 'i' && !(n >= 3 && isAsciiLetter(s[2])))
+      {
+	letter = 'i';
+	length = 2;
+      }
+    else if (n >= 1 && isAsciiLetter(s[0]))
+      {
+	letter = s[0].toLatin1();
+	length = 1;
+      }
+    else
+      {
+	return -1;
+      }
+
+    ushort composed = compose(accent, letter);
+    if (!composed)
+      return -1;
+    result += QChar(composed);
+    return length;
+  }
+
+  // Decodes the command following a backslash. Returns the number of
+  // characters read or -1 when the command is kept as is.
+  int decodeCommand(const QChar *s, int n, QString & result)
+  {
+    Accent accent = AccentCount;
+    switch (s[0].unicode())
+      {
+      case '&':
+	result += QChar('&');
+	return 1;
+      case ',':
+	result += QChar(' ');
+	return 1;
+      case '\'':
+	accent = Acute;
+	break;
+      case '`':
+	accent = Grave;
+	break;
+      case '^':
+	accent = Circumflex;
+	break;
+      case '"':
+      case 0x00A8: // diaeresis sign, as typed by the songs
+	accent = Diaeresis;
+	break;
+      case '~':
+	{
+	  // a tilde that does not compose is an unbreakable space
+	  int length = decodeAccent(Tilde, s + 1, n - 1, result);
+	  if (length < 0)
+	    {
+	      result += QChar(' ');
+	      return 1;
+	    }
+	  return 1 + length;
+	}
+      case 'c':
+	if (n >= 2 && (s[1] == '{' || s[1] == ' '))
+	  {
+	    int skip = s[1] == ' ' ? 2 : 1;
+	    int length = decodeAccent(Cedilla, s + skip, n - skip, result);
+	    if (length >= 0)
+	      return skip + length;
+	  }
+	break;
+      default:
+	break;
+      }
+
+    if (accent != AccentCount)
+      {
+	int length = decodeAccent(accent, s + 1, n - 1, result);
+	return length < 0 ? -1 : 1 + length;
+      }
+
+    if (n >= 4 && s[0] == 'd' && s[1] == 'o' && s[2] == 't' && s[3] == 's')
+      {
+	result += QLatin1String("...");
+	return 4;
+      }
+
+    int length = 0;
+    while (length < n && isAsciiLetter(s[length]))
+      ++length;
+    if (length == 0)
+      return -1;
+
+    for (int i = 0; i < controlWordCount; ++i)
+      {
+	const char *name = controlWords[i].name;
+	if (int(qstrlen(name)) != length)
+	  continue;
+
+	int j = 0;
+	while (j < length && s[j] == QLatin1Char(name[j]))
+	  ++j;
+	if (j < length)
+	  continue;
+
+	// the space or the empty group ending the control word is dropped
+	result += QChar(controlWords[i].character);
+	if (length + 1 < n && s[length] == '{' && s[length + 1] == '}')
+	  return length + 2;
+	if (length < n && s[length] == ' ')
+	  return length + 1;
+	return length;
+      }
+    return -1;
+  }
+
+  const char * transliteration(ushort c)
+  {
+    if (c < 0x00C0)
+      return 0;
+    if (c <= 0x00FF)
+      return latin1Letters[c - 0x00C0];
+
+    const Transliteration *begin = latinExtendedLetters;
+    const Transliteration *end = latinExtendedLetters + latinExtendedLetterCount;
+    while (begin < end)
+      {
+	const Transliteration *middle = begin + (end - begin) / 2;
+	if (middle->character < c)
+	  begin = middle + 1;
+	else
+	  end = middle;
+      }
+    return (begin != latinExtendedLetters + latinExtendedLetterCount
+	    && begin->character == c) ? begin->ascii : 0;
+  }
+
+  // word characters of QRegExp's \w
+  inline bool isWordCharacter(QChar c)
+  {
+    return c.isLetterOrNumber() || c.isMark() || c == '_';
+  }
+}
+
 namespace SbUtils
 {
   //------------------------------------------------------------------------------
   QString latexToUtf8(const QString & AString)
   {
-    QString str(AString);
-    str.replace(QString("\\'e"), QString("é"));
-    str.replace(QString("\\`e"), QString("è"));
-    str.replace(QString("\\^e"), QString("ê"));
-    str.replace(QString("\\¨e"), QString("ë"));
-    str.replace(QString("\\¨i"), QString("ï"));
-    str.replace(QString("\\^i"), QString("î"));
-    str.replace(QString("\\^o"), QString("ô"));
-    str.replace(QString("\\`u"), QString("ù"));
-    str.replace(QString("\\`a"), QString("à"));
-    str.replace(QString("\\^a"), QString("â"));
-    str.replace(QString("\\&"), QString("&"));
-    str.replace(QString("\\~"), QString("~"));
-    str.replace(QString("\\,"), QString(" "));
-    str.replace(QString("~"), QString(" "));
-    str.replace(QString("\\dots"), QString("..."));
+    const QChar *data = AString.constData();
+    const int size = AString.size();
+
+    // most strings have nothing to decode
+    int i = 0;
+    while (i < size && data[i] != '\\' && data[i] != '~')
+      ++i;
+    if (i == size)
+      return AString;
 
+    QString str;
+    str.reserve(size);
+    str += AString.left(i);
+    while (i < size)
+      {
+	QChar c = data[i];
+	if (c == '~')
+	  {
+	    str += QChar(' ');
+	    ++i;
+	    continue;
+	  }
+
+	int length = (c == '\\' && i + 1 < size) ?
+	  decodeCommand(data + i + 1, size - i - 1, str) : -1;
+	if (length < 0)
+	  {
+	    str += c;
+	    ++i;
+	  }
+	else
+	  {
+	    i += 1 + length;
+	  }
+      }
     return str;
   }
   //------------------------------------------------------------------------------
@@ -63,24 +349,39 @@ namespace SbUtils
   //------------------------------------------------------------------------------
   QString stringToFilename(const QString & AString, const QString & sep)
   {
-    QString str(AString);
-    QString item;
-  
-    QStringList list = QStringList() 
-      <<"é"<<"è"<<"ê"<<"ë";
-  
-    foreach(item, list)
-      str.replace(item, QString("e"));
-
-    str.replace(QRegExp("(\\s+)|(\\W+)"), sep);
-
-    str.replace(QString("à"), QString("a"));
-    str.replace(QString("â"), QString("a"));
-    str.replace(QString("ï"), QString("i"));
-    str.replace(QString("î"), QString("i"));
-    str.replace(QString("ô"), QString("o"));
-    str.replace(QString("ù"), QString("u"));
+    const QChar *data = AString.constData();
+    const int size = AString.size();
 
+    QString str;
+    str.reserve(size);
+    int i = 0;
+    while (i < size)
+      {
+	QChar c = data[i];
+	if (c.isSpace())
+	  {
+	    // a run of spaces, as (\s+)
+	    while (i < size && data[i].isSpace())
+	      ++i;
+	    str += sep;
+	  }
+	else if (!isWordCharacter(c))
+	  {
+	    // a run of other characters, spaces included, as (\W+)
+	    while (i < size && !isWordCharacter(data[i]))
+	      ++i;
+	    str += sep;
+	  }
+	else
+	  {
+	    const char *ascii = transliteration(c.unicode());
+	    if (ascii)
+	      str += QLatin1String(ascii);
+	    else
+	      str += c;
+	    ++i;
+	  }
+      }
     return str;
   }
   //------------------------------------------------------------------------------
@@ -108,4 +409,40 @@ namespace SbUtils
       }
     return false;
   }
+  //------------------------------------------------------------------------------
+  QByteArray collationKey(const QString & AString)
+  {
+    if (AString.isEmpty())
+      return QByteArray();
+
+    QVarLengthArray<wchar_t, 128> source(AString.size() + 1);
+    source[AString.toWCharArray(source.data())] = 0;
+
+    size_t length = wcsxfrm(0, source.data(), 0);
+    QVarLengthArray<wchar_t, 512> transformed(length + 1);
+    wcsxfrm(transformed.data(), source.data(), length + 1);
+
+    // big endian so that comparing bytes compares the wide characters
+    QByteArray key;
+    key.resize(int(length) * 4);
+    char *data = key.data();
+    for (size_t i = 0; i < length; ++i)
+      {
+	quint32 c = quint32(transformed[i]);
+	*data++ = char(c >> 24);
+	*data++ = char(c >> 16);
+	*data++ = char(c >> 8);
+	*data++ = char(c);
+      }
+    return key;
+  }
+  //------------------------------------------------------------------------------
+  int compareCollationKeys(const QByteArray & AKey1, const QByteArray & AKey2)
+  {
+    int size = qMin(AKey1.size(), AKey2.size());
+    int cmp = size ? memcmp(AKey1.constData(), AKey2.constData(), size) : 0;
+    if (cmp)
+      return cmp;
+    return AKey1.size() - AKey2.size();
+  }
 }
@@ -20,15 +20,25 @@
 #define __UTILS_HH__
 
 #include <QString>
+#include <QByteArray>
 
 enum SbError { WrongDirectory, WrongExtension, Invalid };
 
 namespace SbUtils
 {
+  /// Decodes the accents, ligatures and spaces of LaTeX in \a str,
+  /// leaving the other commands as they are.
   QString latexToUtf8(const QString & str);
   QString filenameToString(const QString & str);
+  /// Spells the accented letters of \a str in ASCII and replaces each
+  /// run of other characters by \a sep.
   QString stringToFilename(const QString & str, const QString & sep);
   bool copyFile(const QString & ASourcePath, const QString & ATargetDirectory);
+
+  /// Key whose byte order is the collation order of \a str in the
+  /// current locale, see compareCollationKeys().
+  QByteArray collationKey(const QString & str);
+  int compareCollationKeys(const QByteArray & key1, const QByteArray & key2);
 }
 
 #endif // __UTILS_HH__
@@ -0,0 +1,114 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+#include "watchdog.hh"
+
+#include <QDebug>
+
+QAtomicPointer<const char> CWatchdogTag::s_current(0);
+
+//------------------------------------------------------------------------------
+CWatchdogTag::CWatchdogTag(const char *operation)
+  : m_previous(s_current.fetchAndStoreOrdered(operation))
+{}
+//------------------------------------------------------------------------------
+CWatchdogTag::~CWatchdogTag()
+{
+  s_current.fetchAndStoreOrdered(m_previous);
+}
+//------------------------------------------------------------------------------
+const char * CWatchdogTag::current()
+{
+  return s_current;
+}
+//------------------------------------------------------------------------------
+CWatchdog::CWatchdog(int AThreshold, QObject *parent)
+  : QThread(parent)
+  , m_threshold(AThreshold)
+  , m_interval(qMax(10, AThreshold / 4))
+  , m_clock()
+  , m_heartbeat()
+  , m_lastBeat(0)
+  , m_stopped(0)
+{
+  m_clock.start();
+
+  // the heartbeat runs in the thread creating the watchdog
+  m_heartbeat.setInterval(m_interval);
+  connect(&m_heartbeat, SIGNAL(timeout()), SLOT(beat()));
+  m_heartbeat.start();
+}
+//------------------------------------------------------------------------------
+CWatchdog::~CWatchdog()
+{
+  stop();
+  wait();
+}
+//------------------------------------------------------------------------------
+int CWatchdog::threshold() const
+{
+  return m_threshold;
+}
+//------------------------------------------------------------------------------
+void CWatchdog::stop()
+{
+  m_stopped = 1;
+}
+//------------------------------------------------------------------------------
+void CWatchdog::beat()
+{
+  m_lastBeat = m_clock.elapsed();
+}
+//------------------------------------------------------------------------------
+void CWatchdog::run()
+{
+  bool stalled = false;
+  int duration = 0;
+  const char *operation = 0;
+
+  while (!m_stopped)
+    {
+      msleep(m_interval);
+
+      // a beat is expected every interval
+      int blocked = m_clock.elapsed() - int(m_lastBeat) - m_interval;
+      if (blocked > m_threshold)
+	{
+	  const char *current = CWatchdogTag::current();
+	  if (!stalled)
+	    {
+	      stalled = true;
+	      operation = current;
+	      qWarning() << "CWatchdog: event loop blocked in"
+			 << (operation ? operation : "unknown operation");
+	    }
+	  else if (!operation)
+	    {
+	      operation = current;
+	    }
+	  duration = blocked;
+	}
+      else if (stalled)
+	{
+	  QString name = operation ? QString(operation) : tr("unknown operation");
+	  qWarning() << "CWatchdog: event loop blocked for" << duration << "ms in" << name;
+	  emit(stallDetected(name, duration));
+	  stalled = false;
+	  operation = 0;
+	}
+    }
+}
@@ -0,0 +1,95 @@
+// Copyright (C) 2011 Romain Goffe, Alexandre Dupas
+//
+// Songbook Creator is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Songbook Creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+// MA  02110-1301, USA.
+//******************************************************************************
+
+/**
+ * \file watchdog.hh
+ *
+ * Detection of the turns of the event loop blocking the interface.
+ *
+ * A timer of the interface thread records a heartbeat that a separate
+ * thread checks. When no heartbeat happened for longer than the
+ * threshold, the stall is reported with the operation tagged at that
+ * moment by a CWatchdogTag.
+ *
+ */
+#ifndef __WATCHDOG_HH__
+#define __WATCHDOG_HH__
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QTime>
+#include <QTimer>
+
+/** \class CWatchdogTag "watchdog.hh"
+ * \brief CWatchdogTag names the operation running in its scope
+ *
+ * Tags are meant to be created in the interface thread, with a string
+ * literal since the name is read from the watchdog thread.
+ */
+class CWatchdogTag
+{
+public:
+  CWatchdogTag(const char *operation);
+  ~CWatchdogTag();
+
+  /// Innermost operation tagged, or 0.
+  static const char * current();
+
+private:
+  const char *m_previous;
+  static QAtomicPointer<const char> s_current;
+};
+
+/** \class CWatchdog "watchdog.hh"
+ * \brief CWatchdog reports the stalls of the event loop of its thread
+ */
+class CWatchdog : public QThread
+{
+  Q_OBJECT
+
+public:
+  /// Reports the turns longer than \a threshold ms.
+  CWatchdog(int threshold, QObject *parent = 0);
+  ~CWatchdog();
+
+  int threshold() const;
+
+public slots:
+  void stop();
+
+signals:
+  /// Emitted from the watchdog thread once the event loop resumed.
+  void stallDetected(const QString & operation, int duration);
+
+protected:
+  void run();
+
+private slots:
+  void beat();
+
+private:
+  int m_threshold;
+  int m_interval;
+  QTime m_clock;
+  QTimer m_heartbeat;
+  QAtomicInt m_lastBeat;
+  QAtomicInt m_stopped;
+};
+
+#endif // __WATCHDOG_HH__